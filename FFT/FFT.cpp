@@ -4,6 +4,28 @@
 #include <cmath>
 #include <windows.h> // Подключение библиотеки для работы с Windows API (нужно для установки кодировки UTF-8 в PowerShell или CMD)
 #include <stdexcept> // Подключение библиотеки для работы с исключениями
+#include <chrono> // Для измерения времени в режиме бенчмарка
+#include <string> // Для разбора аргументов командной строки
+#include <memory> // Для shared_ptr (вложенный план алгоритма Блюстейна)
+#include <algorithm> // Для fill
+#include <thread> // Для пула потоков
+#include <mutex> // Для синхронизации пула потоков
+#include <condition_variable> // Для ожидания задач в пуле потоков
+#include <atomic> // Для счетчика задач пула потоков
+#include <functional> // Для передачи задач в пул потоков
+#include <fstream> // Для записи спектров STFT
+#include <cstring> // Для memcpy
+#include <map> // Для кэша планов свертки
+#ifndef _WIN32
+#include <sys/mman.h> // mmap для отображения файла в память
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h> // Интринсики AVX2 / AVX-512
+#define FFT_X86_SIMD 1
+#endif
 
 using namespace std;
 
@@ -11,8 +33,198 @@ using namespace std;
 typedef complex<double> Complex;
 typedef vector<Complex> CArray;
 
-// Функция для выполнения БПФ
-void fft(CArray &x) {
+// Комплексный массив в раздельном формате (SoA): действительные и мнимые части отдельно.
+// T - тип отсчетов (float или double)
+template<typename T = double>
+struct SplitArray {
+    vector<T> re;
+    vector<T> im;
+
+    SplitArray() {}
+    explicit SplitArray(size_t n) : re(n), im(n) {}
+    explicit SplitArray(const vector<complex<T>> &x) : re(x.size()), im(x.size()) {
+        for (size_t i = 0; i < x.size(); ++i) {
+            re[i] = x[i].real();
+            im[i] = x[i].imag();
+        }
+    }
+
+    size_t size() const { return re.size(); }
+
+    vector<complex<T>> toComplex() const {
+        vector<complex<T>> x(re.size());
+        for (size_t i = 0; i < re.size(); ++i) {
+            x[i] = complex<T>(re[i], im[i]);
+        }
+        return x;
+    }
+};
+
+// Ядро бабочки: (e, o) -> (e + w*o, e - w*o) для half элементов
+template<typename T>
+using ButterflyKernel = void (*)(T* er, T* ei, T* orr, T* oi, const T* wr, const T* wi, size_t half);
+// Ядро модуля: mag[i] = sqrt(re[i]^2 + im[i]^2)
+template<typename T>
+using MagnitudeKernel = void (*)(const T* re, const T* im, T* mag, size_t n);
+
+template<typename T>
+void butterflyScalar(T* er, T* ei, T* orr, T* oi, const T* wr, const T* wi, size_t half) {
+    for (size_t k = 0; k < half; ++k) {
+        T tr = wr[k] * orr[k] - wi[k] * oi[k];
+        T ti = wr[k] * oi[k] + wi[k] * orr[k];
+        orr[k] = er[k] - tr;
+        oi[k] = ei[k] - ti;
+        er[k] += tr;
+        ei[k] += ti;
+    }
+}
+
+template<typename T>
+void magnitudeScalar(const T* re, const T* im, T* mag, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        mag[i] = sqrt(re[i] * re[i] + im[i] * im[i]);
+    }
+}
+
+#ifdef FFT_X86_SIMD
+// AVX2 + FMA: 4 бабочки double за итерацию (half кратно 4)
+__attribute__((target("avx2,fma")))
+void butterflyAVX2(double* er, double* ei, double* orr, double* oi,
+                   const double* wr, const double* wi, size_t half) {
+    for (size_t k = 0; k < half; k += 4) {
+        __m256d vwr = _mm256_loadu_pd(wr + k), vwi = _mm256_loadu_pd(wi + k);
+        __m256d vor = _mm256_loadu_pd(orr + k), voi = _mm256_loadu_pd(oi + k);
+        __m256d ver = _mm256_loadu_pd(er + k), vei = _mm256_loadu_pd(ei + k);
+        __m256d tr = _mm256_fmsub_pd(vwr, vor, _mm256_mul_pd(vwi, voi));
+        __m256d ti = _mm256_fmadd_pd(vwr, voi, _mm256_mul_pd(vwi, vor));
+        _mm256_storeu_pd(orr + k, _mm256_sub_pd(ver, tr));
+        _mm256_storeu_pd(oi + k, _mm256_sub_pd(vei, ti));
+        _mm256_storeu_pd(er + k, _mm256_add_pd(ver, tr));
+        _mm256_storeu_pd(ei + k, _mm256_add_pd(vei, ti));
+    }
+}
+
+// AVX2 + FMA: 8 бабочек float за итерацию (half кратно 8)
+__attribute__((target("avx2,fma")))
+void butterflyAVX2(float* er, float* ei, float* orr, float* oi,
+                   const float* wr, const float* wi, size_t half) {
+    for (size_t k = 0; k < half; k += 8) {
+        __m256 vwr = _mm256_loadu_ps(wr + k), vwi = _mm256_loadu_ps(wi + k);
+        __m256 vor = _mm256_loadu_ps(orr + k), voi = _mm256_loadu_ps(oi + k);
+        __m256 ver = _mm256_loadu_ps(er + k), vei = _mm256_loadu_ps(ei + k);
+        __m256 tr = _mm256_fmsub_ps(vwr, vor, _mm256_mul_ps(vwi, voi));
+        __m256 ti = _mm256_fmadd_ps(vwr, voi, _mm256_mul_ps(vwi, vor));
+        _mm256_storeu_ps(orr + k, _mm256_sub_ps(ver, tr));
+        _mm256_storeu_ps(oi + k, _mm256_sub_ps(vei, ti));
+        _mm256_storeu_ps(er + k, _mm256_add_ps(ver, tr));
+        _mm256_storeu_ps(ei + k, _mm256_add_ps(vei, ti));
+    }
+}
+
+__attribute__((target("avx2,fma")))
+void magnitudeAVX2(const double* re, const double* im, double* mag, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d r = _mm256_loadu_pd(re + i), m = _mm256_loadu_pd(im + i);
+        _mm256_storeu_pd(mag + i, _mm256_sqrt_pd(_mm256_fmadd_pd(r, r, _mm256_mul_pd(m, m))));
+    }
+    magnitudeScalar(re + i, im + i, mag + i, n - i);
+}
+
+__attribute__((target("avx2,fma")))
+void magnitudeAVX2(const float* re, const float* im, float* mag, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 r = _mm256_loadu_ps(re + i), m = _mm256_loadu_ps(im + i);
+        _mm256_storeu_ps(mag + i, _mm256_sqrt_ps(_mm256_fmadd_ps(r, r, _mm256_mul_ps(m, m))));
+    }
+    magnitudeScalar(re + i, im + i, mag + i, n - i);
+}
+
+// AVX-512: 8 бабочек double за итерацию (half кратно 8)
+__attribute__((target("avx512f")))
+void butterflyAVX512(double* er, double* ei, double* orr, double* oi,
+                     const double* wr, const double* wi, size_t half) {
+    for (size_t k = 0; k < half; k += 8) {
+        __m512d vwr = _mm512_loadu_pd(wr + k), vwi = _mm512_loadu_pd(wi + k);
+        __m512d vor = _mm512_loadu_pd(orr + k), voi = _mm512_loadu_pd(oi + k);
+        __m512d ver = _mm512_loadu_pd(er + k), vei = _mm512_loadu_pd(ei + k);
+        __m512d tr = _mm512_fmsub_pd(vwr, vor, _mm512_mul_pd(vwi, voi));
+        __m512d ti = _mm512_fmadd_pd(vwr, voi, _mm512_mul_pd(vwi, vor));
+        _mm512_storeu_pd(orr + k, _mm512_sub_pd(ver, tr));
+        _mm512_storeu_pd(oi + k, _mm512_sub_pd(vei, ti));
+        _mm512_storeu_pd(er + k, _mm512_add_pd(ver, tr));
+        _mm512_storeu_pd(ei + k, _mm512_add_pd(vei, ti));
+    }
+}
+
+// AVX-512: 16 бабочек float за итерацию (half кратно 16)
+__attribute__((target("avx512f")))
+void butterflyAVX512(float* er, float* ei, float* orr, float* oi,
+                     const float* wr, const float* wi, size_t half) {
+    for (size_t k = 0; k < half; k += 16) {
+        __m512 vwr = _mm512_loadu_ps(wr + k), vwi = _mm512_loadu_ps(wi + k);
+        __m512 vor = _mm512_loadu_ps(orr + k), voi = _mm512_loadu_ps(oi + k);
+        __m512 ver = _mm512_loadu_ps(er + k), vei = _mm512_loadu_ps(ei + k);
+        __m512 tr = _mm512_fmsub_ps(vwr, vor, _mm512_mul_ps(vwi, voi));
+        __m512 ti = _mm512_fmadd_ps(vwr, voi, _mm512_mul_ps(vwi, vor));
+        _mm512_storeu_ps(orr + k, _mm512_sub_ps(ver, tr));
+        _mm512_storeu_ps(oi + k, _mm512_sub_ps(vei, ti));
+        _mm512_storeu_ps(er + k, _mm512_add_ps(ver, tr));
+        _mm512_storeu_ps(ei + k, _mm512_add_ps(vei, ti));
+    }
+}
+
+__attribute__((target("avx512f")))
+void magnitudeAVX512(const double* re, const double* im, double* mag, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512d r = _mm512_loadu_pd(re + i), m = _mm512_loadu_pd(im + i);
+        _mm512_storeu_pd(mag + i, _mm512_maskz_sqrt_pd(0xFF, _mm512_fmadd_pd(r, r, _mm512_mul_pd(m, m))));
+    }
+    magnitudeScalar(re + i, im + i, mag + i, n - i);
+}
+
+__attribute__((target("avx512f")))
+void magnitudeAVX512(const float* re, const float* im, float* mag, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512 r = _mm512_loadu_ps(re + i), m = _mm512_loadu_ps(im + i);
+        _mm512_storeu_ps(mag + i, _mm512_maskz_sqrt_ps(0xFFFF, _mm512_fmadd_ps(r, r, _mm512_mul_ps(m, m))));
+    }
+    magnitudeScalar(re + i, im + i, mag + i, n - i);
+}
+#endif
+
+// Набор ядер, выбранный под текущий процессор
+template<typename T>
+struct FFTKernels {
+    ButterflyKernel<T> butterfly;
+    MagnitudeKernel<T> magnitude;
+    size_t width;       // Сколько бабочек ядро обрабатывает за итерацию
+    const char* name;
+};
+
+// Выбор ядер во время выполнения по результатам cpuid (выполняется один раз для каждого типа)
+template<typename T>
+const FFTKernels<T>& fftKernels() {
+    static const FFTKernels<T> kernels = []() {
+#ifdef FFT_X86_SIMD
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f")) {
+            return FFTKernels<T>{butterflyAVX512, magnitudeAVX512, 64 / sizeof(T), "AVX-512"};
+        }
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+            return FFTKernels<T>{butterflyAVX2, magnitudeAVX2, 32 / sizeof(T), "AVX2"};
+        }
+#endif
+        return FFTKernels<T>{butterflyScalar<T>, magnitudeScalar<T>, 1, "scalar"};
+    }();
+    return kernels;
+}
+
+// Рекурсивная реализация БПФ (эталонная, используется для сравнения в бенчмарке)
+void fftRecursive(CArray &x) {
     try {
         if (x.empty()) {
             throw runtime_error("Входной массив пуст");
@@ -34,8 +246,8 @@ void fft(CArray &x) {
         }
 
         // Рекурсивно применяем БПФ к четным и нечетным частям
-        fft(even);
-        fft(odd);
+        fftRecursive(even);
+        fftRecursive(odd);
 
         // Объединяем результаты
         for (int k = 0; k < N / 2; ++k) {
@@ -49,6 +261,1259 @@ void fft(CArray &x) {
     }
 }
 
+// Буферы для промежуточных данных: у каждого потока свои, поэтому один план
+// можно выполнять из нескольких потоков. Небольшие буферы (до SCRATCH_KEEP_ELEMENTS)
+// живут в потоке и переиспользуются всеми планами. Большие берутся из ScratchPool
+// плана на время вызова и освобождаются вместе с планом, иначе после плана 2^22
+// у каждого потока навсегда оставалось бы по 64 МБ
+enum ScratchSlot { ScratchBluestein, ScratchSplit, ScratchParallel, ScratchSlotCount };
+
+const size_t SCRATCH_KEEP_ELEMENTS = size_t(1) << 16;
+
+// Свободные большие буферы плана; при копировании плана копия начинает с пустого пула
+template<typename T>
+class ScratchPool {
+private:
+    mutex lock;
+    vector<vector<complex<T>>> buffers;
+
+public:
+    ScratchPool() = default;
+    ScratchPool(const ScratchPool&) {}
+    ScratchPool& operator=(const ScratchPool&) { return *this; }
+
+    vector<complex<T>> take(size_t n) {
+        vector<complex<T>> buf;
+        {
+            lock_guard<mutex> guard(lock);
+            if (!buffers.empty()) {
+                buf = move(buffers.back());
+                buffers.pop_back();
+            }
+        }
+        if (buf.size() < n) {
+            buf.resize(n);
+        }
+        return buf;
+    }
+
+    void give(vector<complex<T>> &&buf) {
+        lock_guard<mutex> guard(lock);
+        buffers.push_back(move(buf));
+    }
+};
+
+template<typename T>
+class ScratchBuffer {
+private:
+    ScratchPool<T> *pool = nullptr;
+    vector<complex<T>> own; // Большой буфер, взятый из пула плана
+    complex<T>* ptr;
+
+public:
+    ScratchBuffer(ScratchSlot slot, size_t n, ScratchPool<T> &planPool) {
+        if (n > SCRATCH_KEEP_ELEMENTS) {
+            pool = &planPool;
+            own = planPool.take(n);
+            ptr = own.data();
+            return;
+        }
+        thread_local vector<complex<T>> buffers[ScratchSlotCount];
+        vector<complex<T>> &buf = buffers[slot];
+        if (buf.size() < n) {
+            buf.resize(n);
+        }
+        ptr = buf.data();
+    }
+
+    ~ScratchBuffer() {
+        if (pool != nullptr) {
+            pool->give(move(own));
+        }
+    }
+
+    ScratchBuffer(const ScratchBuffer&) = delete;
+    ScratchBuffer& operator=(const ScratchBuffer&) = delete;
+
+    complex<T>* data() const { return ptr; }
+};
+
+// Вычисление sin/cos на этапе компиляции (ряд Тейлора после приведения к [-pi, pi])
+constexpr double constexprSin(double x) {
+    const double pi = 3.14159265358979323846;
+    while (x > pi) x -= 2 * pi;
+    while (x < -pi) x += 2 * pi;
+    double term = x, sum = x;
+    for (int n = 1; n < 30; ++n) {
+        term *= -x * x / ((2 * n) * (2 * n + 1));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr double constexprCos(double x) {
+    return constexprSin(x + 3.14159265358979323846 / 2);
+}
+
+// Таблицы кодлета размера N, построенные на этапе компиляции:
+// бит-реверсная перестановка и поворотные множители этапа длины len в [len/2, len)
+template<typename T, size_t N>
+struct CodeletTables {
+    size_t rev[N] = {};
+    T wr[N] = {};
+    T wi[N] = {};
+
+    constexpr CodeletTables() {
+        size_t bits = 0;
+        while ((size_t(1) << bits) < N) {
+            ++bits;
+        }
+        for (size_t i = 0; i < N; ++i) {
+            size_t r = 0;
+            for (size_t b = 0; b < bits; ++b) {
+                if (i & (size_t(1) << b)) {
+                    r |= size_t(1) << (bits - 1 - b);
+                }
+            }
+            rev[i] = r;
+        }
+        for (size_t len = 2; len <= N; len <<= 1) {
+            for (size_t k = 0; k < len / 2; ++k) {
+                double angle = -2 * 3.14159265358979323846 * double(k) / double(len);
+                wr[len / 2 + k] = T(constexprCos(angle));
+                wi[len / 2 + k] = T(constexprSin(angle));
+            }
+        }
+    }
+};
+
+// Кодлет: полностью развернутое БПФ фиксированного размера N (степень двойки).
+// Перестановка, все этапы и все бабочки разворачиваются шаблонами на этапе
+// компиляции, поворотные множители - константы; для бабочек с k = 0 умножение опускается.
+// Данные обрабатываются в локальных массивах, поэтому нет ни циклов, ни обращений к таблицам
+template<typename T, size_t N>
+struct FFTCodelet {
+    static constexpr CodeletTables<T, N> tables{};
+
+    static void run(complex<T>* x) {
+        T re[N], im[N];
+        load(x, re, im, make_index_sequence<N>());
+        stage<2>(re, im);
+        store(x, re, im, make_index_sequence<N>());
+    }
+
+private:
+    template<size_t... I>
+    static void load(const complex<T>* x, T* re, T* im, index_sequence<I...>) {
+        ((re[I] = x[tables.rev[I]].real(), im[I] = x[tables.rev[I]].imag()), ...);
+    }
+
+    template<size_t... I>
+    static void store(complex<T>* x, const T* re, const T* im, index_sequence<I...>) {
+        ((x[I] = complex<T>(re[I], im[I])), ...);
+    }
+
+    template<size_t Len>
+    static void stage(T* re, T* im) {
+        if constexpr (Len <= N) {
+            butterflies<Len>(re, im, make_index_sequence<N / 2>());
+            stage<Len * 2>(re, im);
+        }
+    }
+
+    template<size_t Len, size_t... B>
+    static void butterflies(T* re, T* im, index_sequence<B...>) {
+        (butterfly<Len, B>(re, im), ...);
+    }
+
+    // Бабочка номер B этапа длины Len
+    template<size_t Len, size_t B>
+    static void butterfly(T* re, T* im) {
+        constexpr size_t half = Len / 2;
+        constexpr size_t k = B % half;
+        constexpr size_t i = (B / half) * Len + k;
+        constexpr size_t j = i + half;
+        T tr = re[j], ti = im[j];
+        if constexpr (k != 0) {
+            constexpr T c = tables.wr[half + k], s = tables.wi[half + k];
+            tr = c * re[j] - s * im[j];
+            ti = c * im[j] + s * re[j];
+        }
+        re[j] = re[i] - tr;
+        im[j] = im[i] - ti;
+        re[i] += tr;
+        im[i] += ti;
+    }
+};
+
+// БПФ фиксированного размера без плана: fftFixed<16>(data)
+template<size_t N, typename T>
+void fftFixed(complex<T>* x) {
+    FFTCodelet<T, N>::run(x);
+}
+
+// План БПФ: перестановка входа и таблицы поворотных множителей вычисляются
+// один раз для заданного размера, после чего преобразование выполняется
+// итеративно и на месте. Размер может быть любым:
+//  - степень двойки до 64: развернутый кодлет;
+//  - степень двойки: этапы radix-2 (для SoA - SIMD-ядра);
+//  - N = 2^a * 3^b * 5^c * 7^d: смешанное основание (этапы radix-2/3/4/5/7);
+//  - остальные N: алгоритм Блюстейна (chirp-z) через план степени двойки.
+// T - тип отсчетов (float или double); множители вычисляются в double
+template<typename T = double>
+class FFTPlan {
+public:
+    enum class Kind { Radix2, MixedRadix, Bluestein, Codelet };
+    typedef complex<T> Cpx;
+    typedef vector<Cpx> Array;
+
+private:
+    // Этап смешанного основания: бабочки radix точек с шагом span
+    struct Stage {
+        size_t radix;
+        size_t span;      // Длина уже объединенных блоков перед этапом
+        size_t offset;    // Начало множителей этапа в stageTwiddles
+    };
+
+    size_t N;              // Размер преобразования
+    Kind kind;
+    vector<pair<size_t, size_t>> swaps; // Перестановка входа (бит-/дигит-реверс) в виде обменов
+    Array twiddles;       // Radix-2: поворотные множители этапа длины len лежат в [len/2, len)
+    vector<T> twRe, twIm;  // Те же множители в раздельном формате для SIMD-ядер
+    vector<Stage> stages;  // Смешанное основание: этапы по порядку выполнения
+    Array stageTwiddles;  // Смешанное основание: W_L^(j*k), j = 1..radix-1, для каждого k
+    size_t M = 0;          // Блюстейн: размер свертки (степень двойки >= 2N-1)
+    shared_ptr<const FFTPlan> inner; // Блюстейн: план размера M
+    Array chirp;          // Блюстейн: exp(-i*pi*n^2/N)
+    Array chirpSpectrum;  // Блюстейн: БПФ сопряженного чирпа, деленное на M
+    void (*codelet)(Cpx*) = nullptr; // Кодлет фиксированного размера
+    mutable ScratchPool<T> scratchPool; // Большие временные буферы (SoA-вход, Блюстейн)
+
+    // Корень из единицы exp(i*angle), вычисленный в double
+    static Cpx root(double angle) {
+        return Cpx(T(cos(angle)), T(sin(angle)));
+    }
+
+public:
+    // useCodelets = false отключает кодлеты (для сравнения в бенчмарке)
+    explicit FFTPlan(size_t n, bool useCodelets = true) : N(n) {
+        try {
+            if (N == 0) {
+                throw runtime_error("Размер плана БПФ равен нулю");
+            }
+
+            // Разложение на множители 4, 2, 3, 5, 7 (пары двоек объединяются в radix-4)
+            vector<size_t> factors;
+            size_t rest = N;
+            for (size_t r : {4, 2, 3, 5, 7}) {
+                while (rest % r == 0) {
+                    factors.push_back(r);
+                    rest /= r;
+                }
+            }
+
+            if (useCodelets && selectCodelet()) {
+                kind = Kind::Codelet;
+            } else if (rest != 1) {
+                kind = Kind::Bluestein;
+                buildBluestein();
+            } else if ((N & (N - 1)) == 0) {
+                kind = Kind::Radix2;
+                size_t bits = 0;
+                while ((size_t(1) << bits) < N) {
+                    ++bits;
+                }
+                buildPermutation(vector<size_t>(bits, 2));
+                buildRadix2();
+            } else {
+                kind = Kind::MixedRadix;
+                buildPermutation(factors);
+                buildStages(factors);
+            }
+        } catch (const exception& e) {
+            cerr << "Ошибка при построении плана БПФ: " << e.what() << endl;
+            throw;
+        }
+    }
+
+    size_t size() const { return N; }
+    Kind type() const { return kind; }
+
+    // Выполнение прямого БПФ на месте
+    void execute(Array &x) const {
+        if (x.size() != N) {
+            throw runtime_error("Размер массива не совпадает с размером плана БПФ");
+        }
+        execute(x.data());
+    }
+
+    // Выполнение прямого БПФ на месте над буфером из N элементов
+    void execute(Cpx* x) const {
+        switch (kind) {
+        case Kind::Radix2:
+            permute(x);
+            executeRadix2(x);
+            break;
+        case Kind::MixedRadix:
+            permute(x);
+            executeStages(x);
+            break;
+        case Kind::Bluestein:
+            executeBluestein(x);
+            break;
+        case Kind::Codelet:
+            codelet(x);
+            break;
+        }
+    }
+
+    // Выполнение прямого БПФ на месте для данных в раздельном формате (SoA).
+    // Этапы, где число бабочек в блоке не меньше ширины SIMD-ядра, идут через
+    // векторное ядро, первые короткие этапы - через скалярное.
+    // Для размеров, не являющихся степенью двойки, данные упаковываются во
+    // временный комплексный буфер потока
+    void execute(SplitArray<T> &x) const {
+        if (x.size() != N) {
+            throw runtime_error("Размер массива не совпадает с размером плана БПФ");
+        }
+        T* re = x.re.data();
+        T* im = x.im.data();
+
+        if (kind != Kind::Radix2) {
+            ScratchBuffer<T> scratch(ScratchSplit, N, scratchPool);
+            Cpx* buf = scratch.data();
+            for (size_t i = 0; i < N; ++i) {
+                buf[i] = Cpx(re[i], im[i]);
+            }
+            execute(buf);
+            for (size_t i = 0; i < N; ++i) {
+                re[i] = buf[i].real();
+                im[i] = buf[i].imag();
+            }
+            return;
+        }
+
+        for (const auto &sw : swaps) {
+            swap(re[sw.first], re[sw.second]);
+            swap(im[sw.first], im[sw.second]);
+        }
+
+        const FFTKernels<T>& kernels = fftKernels<T>();
+        for (size_t len = 2; len <= N; len <<= 1) {
+            size_t half = len / 2;
+            ButterflyKernel<T> kernel = half >= kernels.width ? kernels.butterfly : butterflyScalar<T>;
+            for (size_t start = 0; start < N; start += len) {
+                kernel(re + start, im + start, re + start + half, im + start + half,
+                       &twRe[half], &twIm[half], half);
+            }
+        }
+    }
+
+private:
+    bool selectCodelet() {
+        switch (N) {
+        case 2: codelet = FFTCodelet<T, 2>::run; return true;
+        case 4: codelet = FFTCodelet<T, 4>::run; return true;
+        case 8: codelet = FFTCodelet<T, 8>::run; return true;
+        case 16: codelet = FFTCodelet<T, 16>::run; return true;
+        case 32: codelet = FFTCodelet<T, 32>::run; return true;
+        case 64: codelet = FFTCodelet<T, 64>::run; return true;
+        default: return false;
+        }
+    }
+
+    // Перестановка входа для итеративного алгоритма с прореживанием по времени.
+    // Позиция p после перестановки берет элемент с индексом src(p), где
+    // последний этап (основание f) объединяет f подпоследовательностей x[j + f*n].
+    // Перестановка раскладывается на циклы и хранится как последовательность обменов
+    void buildPermutation(const vector<size_t> &factors) {
+        vector<size_t> perm(N);
+        for (size_t p = 0; p < N; ++p) {
+            size_t src = 0, mult = 1, q = p, len = N;
+            for (size_t l = factors.size(); l-- > 0;) {
+                len /= factors[l];
+                src += (q / len) * mult;
+                mult *= factors[l];
+                q %= len;
+            }
+            perm[p] = src;
+        }
+
+        vector<bool> visited(N, false);
+        for (size_t start = 0; start < N; ++start) {
+            if (visited[start]) {
+                continue;
+            }
+            visited[start] = true;
+            for (size_t p = start; perm[p] != start; p = perm[p]) {
+                swaps.push_back({p, perm[p]});
+                visited[perm[p]] = true;
+            }
+        }
+    }
+
+    void permute(Cpx* x) const {
+        for (const auto &sw : swaps) {
+            swap(x[sw.first], x[sw.second]);
+        }
+    }
+
+    // Поворотные множители каждого этапа radix-2 хранятся подряд,
+    // формула совпадает с рекурсивной версией, поэтому результат тот же
+    void buildRadix2() {
+        twiddles.resize(N);
+        for (size_t len = 2; len <= N; len <<= 1) {
+            size_t half = len / 2;
+            for (size_t k = 0; k < half; ++k) {
+                twiddles[half + k] = root(-2 * M_PI * k / len);
+            }
+        }
+        twRe.resize(N);
+        twIm.resize(N);
+        for (size_t i = 0; i < N; ++i) {
+            twRe[i] = twiddles[i].real();
+            twIm[i] = twiddles[i].imag();
+        }
+    }
+
+    // Итеративное объединение: этапы длины 2, 4, ..., N
+    void executeRadix2(Cpx* x) const {
+        for (size_t len = 2; len <= N; len <<= 1) {
+            size_t half = len / 2;
+            const Cpx* w = &twiddles[half];
+            for (size_t start = 0; start < N; start += len) {
+                Cpx* even = &x[start];
+                Cpx* odd = &x[start + half];
+                for (size_t k = 0; k < half; ++k) {
+                    Cpx t = w[k] * odd[k];
+                    odd[k] = even[k] - t;
+                    even[k] = even[k] + t;
+                }
+            }
+        }
+    }
+
+    void buildStages(const vector<size_t> &factors) {
+        size_t span = 1;
+        for (size_t r : factors) {
+            size_t len = span * r;
+            stages.push_back({r, span, stageTwiddles.size()});
+            for (size_t k = 0; k < span; ++k) {
+                for (size_t j = 1; j < r; ++j) {
+                    stageTwiddles.push_back(root(-2 * M_PI * double(j * k) / len));
+                }
+            }
+            span = len;
+        }
+    }
+
+    // Этапы смешанного основания: для каждого блока длины span*radix берутся
+    // radix элементов с шагом span, умножаются на поворотные множители
+    // и проходят через ДПФ размера radix
+    void executeStages(Cpx* x) const {
+        for (const Stage &st : stages) {
+            switch (st.radix) {
+            case 2: stageRadix2(x, st); break;
+            case 3: stageRadix3(x, st); break;
+            case 4: stageRadix4(x, st); break;
+            case 5: stageRadix5(x, st); break;
+            default: stageGeneric(x, st); break;
+            }
+        }
+    }
+
+    void stageRadix2(Cpx* x, const Stage &st) const {
+        size_t span = st.span;
+        const Cpx* tw = &stageTwiddles[st.offset];
+        for (size_t start = 0; start < N; start += 2 * span) {
+            Cpx* base = x + start;
+            for (size_t k = 0; k < span; ++k) {
+                Cpx v0 = base[k];
+                Cpx v1 = base[k + span] * tw[k];
+                base[k] = v0 + v1;
+                base[k + span] = v0 - v1;
+            }
+        }
+    }
+
+    void stageRadix3(Cpx* x, const Stage &st) const {
+        const T s3 = T(sin(2 * M_PI / 3));
+        size_t span = st.span;
+        const Cpx* tw = &stageTwiddles[st.offset];
+        for (size_t start = 0; start < N; start += 3 * span) {
+            Cpx* base = x + start;
+            for (size_t k = 0; k < span; ++k) {
+                const Cpx* w = tw + 2 * k;
+                Cpx v0 = base[k];
+                Cpx v1 = base[k + span] * w[0];
+                Cpx v2 = base[k + 2 * span] * w[1];
+                Cpx sum = v1 + v2;
+                Cpx mid = v0 - T(0.5) * sum;
+                Cpx rot = (v1 - v2) * Cpx(0, -s3);
+                base[k] = v0 + sum;
+                base[k + span] = mid + rot;
+                base[k + 2 * span] = mid - rot;
+            }
+        }
+    }
+
+    void stageRadix4(Cpx* x, const Stage &st) const {
+        size_t span = st.span;
+        const Cpx* tw = &stageTwiddles[st.offset];
+        for (size_t start = 0; start < N; start += 4 * span) {
+            Cpx* base = x + start;
+            for (size_t k = 0; k < span; ++k) {
+                const Cpx* w = tw + 3 * k;
+                Cpx v0 = base[k];
+                Cpx v1 = base[k + span] * w[0];
+                Cpx v2 = base[k + 2 * span] * w[1];
+                Cpx v3 = base[k + 3 * span] * w[2];
+                Cpx a0 = v0 + v2, a1 = v0 - v2;
+                Cpx b0 = v1 + v3;
+                Cpx b1 = Cpx((v1 - v3).imag(), -(v1 - v3).real()); // (v1 - v3) * (-i)
+                base[k] = a0 + b0;
+                base[k + span] = a1 + b1;
+                base[k + 2 * span] = a0 - b0;
+                base[k + 3 * span] = a1 - b1;
+            }
+        }
+    }
+
+    void stageRadix5(Cpx* x, const Stage &st) const {
+        const T c1 = T(cos(2 * M_PI / 5)), c2 = T(cos(4 * M_PI / 5));
+        const T s1 = T(sin(2 * M_PI / 5)), s2 = T(sin(4 * M_PI / 5));
+        size_t span = st.span;
+        const Cpx* tw = &stageTwiddles[st.offset];
+        for (size_t start = 0; start < N; start += 5 * span) {
+            Cpx* base = x + start;
+            for (size_t k = 0; k < span; ++k) {
+                const Cpx* w = tw + 4 * k;
+                Cpx v0 = base[k];
+                Cpx v1 = base[k + span] * w[0];
+                Cpx v2 = base[k + 2 * span] * w[1];
+                Cpx v3 = base[k + 3 * span] * w[2];
+                Cpx v4 = base[k + 4 * span] * w[3];
+                Cpx a1 = v1 + v4, a2 = v2 + v3;
+                Cpx b1 = v1 - v4, b2 = v2 - v3;
+                Cpx t1 = v0 + c1 * a1 + c2 * a2;
+                Cpx t2 = v0 + c2 * a1 + c1 * a2;
+                Cpx u1 = s1 * b1 + s2 * b2;
+                Cpx u2 = s2 * b1 - s1 * b2;
+                // Умножение на -i: (re, im) -> (im, -re)
+                Cpx iu1(u1.imag(), -u1.real()), iu2(u2.imag(), -u2.real());
+                base[k] = v0 + a1 + a2;
+                base[k + span] = t1 + iu1;
+                base[k + 4 * span] = t1 - iu1;
+                base[k + 2 * span] = t2 + iu2;
+                base[k + 3 * span] = t2 - iu2;
+            }
+        }
+    }
+
+    // Общий случай (radix 7): прямое ДПФ размера radix
+    void stageGeneric(Cpx* x, const Stage &st) const {
+        size_t r = st.radix, span = st.span;
+        const Cpx* tw = &stageTwiddles[st.offset];
+        Cpx roots[7];
+        for (size_t t = 0; t < r; ++t) {
+            roots[t] = root(-2 * M_PI * double(t) / r);
+        }
+        for (size_t start = 0; start < N; start += r * span) {
+            Cpx* base = x + start;
+            for (size_t k = 0; k < span; ++k) {
+                const Cpx* w = tw + (r - 1) * k;
+                Cpx v[7];
+                v[0] = base[k];
+                for (size_t j = 1; j < r; ++j) {
+                    v[j] = base[k + j * span] * w[j - 1];
+                }
+                for (size_t q = 0; q < r; ++q) {
+                    Cpx acc = v[0];
+                    for (size_t j = 1; j < r; ++j) {
+                        acc += v[j] * roots[(j * q) % r];
+                    }
+                    base[k + q * span] = acc;
+                }
+            }
+        }
+    }
+
+    // Алгоритм Блюстейна: X[k] = w[k] * sum(x[n]*w[n] * conj(w[k-n])), w[n] = exp(-i*pi*n^2/N).
+    // Свертка вычисляется через БПФ размера M (степень двойки)
+    void buildBluestein() {
+        M = 1;
+        while (M < 2 * N - 1) {
+            M <<= 1;
+        }
+        inner = make_shared<const FFTPlan>(M);
+
+        chirp.resize(N);
+        for (size_t n = 0; n < N; ++n) {
+            // n^2 берется по модулю 2N, чтобы не терять точность при больших n
+            size_t n2 = (n * n) % (2 * N);
+            chirp[n] = root(-M_PI * double(n2) / N);
+        }
+
+        chirpSpectrum.assign(M, Cpx(0, 0));
+        chirpSpectrum[0] = conj(chirp[0]);
+        for (size_t n = 1; n < N; ++n) {
+            chirpSpectrum[n] = conj(chirp[n]);
+            chirpSpectrum[M - n] = conj(chirp[n]);
+        }
+        inner->execute(chirpSpectrum);
+        for (size_t k = 0; k < M; ++k) {
+            chirpSpectrum[k] /= T(M);
+        }
+    }
+
+    void executeBluestein(Cpx* x) const {
+        ScratchBuffer<T> scratch(ScratchBluestein, M, scratchPool);
+        Cpx* a = scratch.data();
+        for (size_t n = 0; n < N; ++n) {
+            a[n] = x[n] * chirp[n];
+        }
+        fill(a + N, a + M, Cpx(0, 0));
+
+        inner->execute(a);
+        // Обратное БПФ через сопряжение: ifft(A) = conj(fft(conj(A))) / M
+        for (size_t k = 0; k < M; ++k) {
+            a[k] = conj(a[k] * chirpSpectrum[k]);
+        }
+        inner->execute(a);
+
+        for (size_t k = 0; k < N; ++k) {
+            x[k] = chirp[k] * conj(a[k]);
+        }
+    }
+};
+
+// План БПФ для действительного входа. N действительных отсчетов упаковываются
+// в N/2 комплексных (z[k] = x[2k] + i*x[2k+1]), над ними выполняется
+// комплексное БПФ половинного размера, а затем по эрмитовой симметрии
+// восстанавливаются N/2+1 неизбыточных бинов спектра
+template<typename T = double>
+class RealFFTPlan {
+public:
+    typedef complex<T> Cpx;
+    typedef vector<Cpx> Array;
+
+private:
+    size_t N;         // Число действительных отсчетов
+    FFTPlan<T> half;  // Комплексный план размера N/2
+    Array w;          // Множители exp(-2*pi*i*k/N), k = 0..N/2-1
+
+public:
+    explicit RealFFTPlan(size_t n) : N(n), half(checkedHalf(n)), w(n / 2) {
+        for (size_t k = 0; k < N / 2; ++k) {
+            double angle = -2 * M_PI * k / N;
+            w[k] = Cpx(T(cos(angle)), T(sin(angle)));
+        }
+    }
+
+    size_t size() const { return N; }
+    size_t spectrumSize() const { return N / 2 + 1; }
+
+    // Прямое преобразование: N отсчетов -> N/2+1 бинов
+    void forward(const vector<T> &x, Array &spectrum) const {
+        if (x.size() != N) {
+            throw runtime_error("Размер массива не совпадает с размером плана БПФ");
+        }
+        size_t M = N / 2;
+        spectrum.resize(M + 1);
+        for (size_t k = 0; k < M; ++k) {
+            spectrum[k] = Cpx(x[2 * k], x[2 * k + 1]);
+        }
+        half.execute(spectrum.data());
+
+        // Разделение спектров четных и нечетных отсчетов, пары k и M-k обрабатываются вместе
+        Cpx z0 = spectrum[0];
+        spectrum[0] = Cpx(z0.real() + z0.imag(), 0);
+        spectrum[M] = Cpx(z0.real() - z0.imag(), 0);
+        for (size_t k = 1; k <= M / 2; ++k) {
+            Cpx a = spectrum[k];
+            Cpx b = conj(spectrum[M - k]);
+            Cpx e = (a + b) * T(0.5);
+            Cpx o = (a - b) * Cpx(0, T(-0.5));
+            Cpx t = w[k] * o;
+            spectrum[k] = e + t;
+            spectrum[M - k] = conj(e - t);
+        }
+    }
+
+    // Обратное преобразование: N/2+1 бинов -> N отсчетов (с нормировкой 1/N)
+    void inverse(const Array &spectrum, vector<T> &x) const {
+        size_t M = N / 2;
+        if (spectrum.size() != M + 1) {
+            throw runtime_error("Размер спектра не совпадает с размером плана БПФ");
+        }
+        x.resize(N);
+        // Выходной буфер используется как массив из M комплексных чисел
+        Cpx* z = reinterpret_cast<Cpx*>(x.data());
+
+        for (size_t k = 0; k <= M / 2; ++k) {
+            Cpx a = spectrum[k];
+            Cpx b = conj(spectrum[M - k]);
+            Cpx e = (a + b) * T(0.5);
+            Cpx o = (a - b) * T(0.5) * conj(w[k]);
+            // Сразу сопрягаем: обратное БПФ = conj(БПФ(conj(Z))) / M
+            z[k] = conj(e + Cpx(0, 1) * o);
+            if (k != 0 && k != M - k) {
+                z[M - k] = conj(conj(e) + Cpx(0, 1) * conj(o));
+            }
+        }
+        half.execute(z);
+
+        T scale = T(1) / T(M);
+        for (size_t k = 0; k < M; ++k) {
+            z[k] = conj(z[k]) * scale;
+        }
+    }
+
+private:
+    static size_t checkedHalf(size_t n) {
+        if (n < 2 || n % 2 != 0) {
+            throw runtime_error("Размер действительного БПФ должен быть четным");
+        }
+        return n / 2;
+    }
+};
+
+// Прямое БПФ действительного сигнала: возвращает N/2+1 неизбыточных бинов
+template<typename T>
+vector<complex<T>> rfft(const vector<T> &x) {
+    try {
+        if (x.empty()) {
+            throw runtime_error("Входной массив пуст");
+        }
+        RealFFTPlan<T> plan(x.size());
+        vector<complex<T>> spectrum;
+        plan.forward(x, spectrum);
+        return spectrum;
+    } catch (const exception& e) {
+        cerr << "Ошибка в функции RFFT: " << e.what() << endl;
+        throw;
+    }
+}
+
+// Обратное БПФ по половинному спектру: возвращает N = 2*(размер спектра - 1) отсчетов
+template<typename T>
+vector<T> irfft(const vector<complex<T>> &spectrum) {
+    try {
+        if (spectrum.size() < 2) {
+            throw runtime_error("Спектр должен содержать не менее двух бинов");
+        }
+        RealFFTPlan<T> plan(2 * (spectrum.size() - 1));
+        vector<T> x;
+        plan.inverse(spectrum, x);
+        return x;
+    } catch (const exception& e) {
+        cerr << "Ошибка в функции IRFFT: " << e.what() << endl;
+        throw;
+    }
+}
+
+// Функция для выполнения БПФ (строит план под размер массива)
+template<typename T>
+void fft(vector<complex<T>> &x) {
+    try {
+        if (x.empty()) {
+            throw runtime_error("Входной массив пуст");
+        }
+        FFTPlan<T> plan(x.size());
+        plan.execute(x);
+    } catch (const exception& e) {
+        cerr << "Ошибка в функции FFT: " << e.what() << endl;
+        throw;
+    }
+}
+
+// Пул потоков: рабочие потоки создаются один раз и ждут задач.
+// parallelFor делит диапазон [0, count) на порции, которые разбирают рабочие
+// потоки и вызывающий поток; возврат происходит после выполнения всех порций.
+// Одновременно выполняется одна задача (вызовы из разных потоков ждут друг друга),
+// вложенный вызов из задачи пула (например, fft_batch внутри параллельного плана)
+// выполняется в вызывающем потоке
+class ThreadPool {
+private:
+    vector<thread> workers;
+    mutex runLock;             // Одна задача пула за раз
+    mutex m;
+    condition_variable wake, finished;
+    const function<void(size_t, size_t)>* job = nullptr;
+    size_t jobCount = 0;       // Размер диапазона текущей задачи
+    size_t chunkSize = 1;      // Размер порции
+    atomic<size_t> next{0};    // Начало следующей свободной порции
+    size_t active = 0;         // Рабочие потоки, еще не закончившие задачу
+    size_t generation = 0;     // Номер задачи, чтобы потоки не брали одну задачу дважды
+    bool stopping = false;
+    exception_ptr error;       // Первое исключение, возникшее в задаче
+
+    static bool& insideTask() {
+        thread_local bool inside = false;
+        return inside;
+    }
+
+public:
+    // threads - общее число потоков с учетом вызывающего
+    explicit ThreadPool(size_t threads = thread::hardware_concurrency()) {
+        if (threads == 0) {
+            threads = 1;
+        }
+        for (size_t i = 1; i < threads; ++i) {
+            workers.emplace_back(&ThreadPool::workerLoop, this);
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            lock_guard<mutex> lock(m);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto &th : workers) {
+            if (th.joinable()) {
+                th.join();
+            }
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t size() const { return workers.size() + 1; }
+
+    void parallelFor(size_t count, const function<void(size_t, size_t)> &body) {
+        if (count == 0) {
+            return;
+        }
+        if (workers.empty() || count == 1 || insideTask()) {
+            body(0, count);
+            return;
+        }
+        lock_guard<mutex> exclusive(runLock);
+        {
+            lock_guard<mutex> lock(m);
+            job = &body;
+            jobCount = count;
+            // Несколько порций на поток сглаживают неравномерную нагрузку
+            chunkSize = max<size_t>(1, count / (4 * size()));
+            next = 0;
+            active = workers.size();
+            error = nullptr;
+            ++generation;
+        }
+        wake.notify_all();
+        insideTask() = true;
+        runChunks();
+        insideTask() = false;
+
+        unique_lock<mutex> lock(m);
+        finished.wait(lock, [this] { return active == 0; });
+        job = nullptr;
+        if (error) {
+            rethrow_exception(error);
+        }
+    }
+
+private:
+    void runChunks() {
+        for (;;) {
+            size_t begin = next.fetch_add(chunkSize);
+            if (begin >= jobCount) {
+                break;
+            }
+            try {
+                (*job)(begin, min(jobCount, begin + chunkSize));
+            } catch (...) {
+                lock_guard<mutex> lock(m);
+                if (!error) {
+                    error = current_exception();
+                }
+            }
+        }
+    }
+
+    void workerLoop() {
+        insideTask() = true;
+        size_t seen = 0;
+        for (;;) {
+            {
+                unique_lock<mutex> lock(m);
+                wake.wait(lock, [&] { return stopping || generation != seen; });
+                if (stopping) {
+                    return;
+                }
+                seen = generation;
+            }
+            runChunks();
+            {
+                lock_guard<mutex> lock(m);
+                if (--active == 0) {
+                    finished.notify_one();
+                }
+            }
+        }
+    }
+};
+
+// Общий пул потоков по числу ядер
+ThreadPool& defaultThreadPool() {
+    static ThreadPool pool;
+    return pool;
+}
+
+// Блочное транспонирование матрицы rows x cols: dst[c*rows + r] = src[r*cols + c]
+template<typename T>
+void transpose(const complex<T>* src, complex<T>* dst, size_t rows, size_t cols, ThreadPool &pool) {
+    const size_t tile = 32;
+    size_t tileRows = (rows + tile - 1) / tile;
+    pool.parallelFor(tileRows, [&](size_t begin, size_t end) {
+        for (size_t tr = begin; tr < end; ++tr) {
+            size_t r0 = tr * tile, r1 = min(rows, r0 + tile);
+            for (size_t c0 = 0; c0 < cols; c0 += tile) {
+                size_t c1 = min(cols, c0 + tile);
+                for (size_t r = r0; r < r1; ++r) {
+                    for (size_t c = c0; c < c1; ++c) {
+                        dst[c * rows + r] = src[r * cols + c];
+                    }
+                }
+            }
+        }
+    });
+}
+
+// Многопоточное БПФ большого размера по схеме "шесть шагов" (вариант four-step):
+// N = N1 * N2, вход рассматривается как матрица N1 x N2.
+//  1) транспонирование -> N2 строк длины N1;
+//  2) БПФ строк длины N1 и умножение на W_N^(n2*k1);
+//  3) транспонирование -> N1 строк длины N2;
+//  4) БПФ строк длины N2;
+//  5) транспонирование в естественный порядок X[k1 + N1*k2].
+// Все строки помещаются в кэш, строки и блоки транспонирования
+// распределяются по потокам пула
+template<typename T = double>
+class ParallelFFTPlan {
+public:
+    typedef complex<T> Cpx;
+    typedef vector<Cpx> Array;
+
+private:
+    size_t N, N1, N2;
+    ThreadPool &pool;
+    shared_ptr<const FFTPlan<T>> rowPlan;  // План размера N1
+    shared_ptr<const FFTPlan<T>> colPlan;  // План размера N2
+    shared_ptr<const FFTPlan<T>> fullPlan; // Если N не раскладывается, выполняется обычный план
+    Array twiddles;                        // W_N^(n2*k1), хранится построчно [n2][k1]
+    mutable ScratchPool<T> scratchPool;    // Временный буфер транспонирования
+
+public:
+    ParallelFFTPlan(size_t n, ThreadPool &threadPool = defaultThreadPool()) : N(n), N1(1), N2(n), pool(threadPool) {
+        try {
+            if (N == 0) {
+                throw runtime_error("Размер плана БПФ равен нулю");
+            }
+            // N1 - наибольший делитель N, не превосходящий sqrt(N)
+            for (size_t d = 1; d * d <= N; ++d) {
+                if (N % d == 0) {
+                    N1 = d;
+                }
+            }
+            N2 = N / N1;
+
+            if (N1 == 1) {
+                fullPlan = make_shared<const FFTPlan<T>>(N);
+                return;
+            }
+            rowPlan = make_shared<const FFTPlan<T>>(N1);
+            colPlan = N1 == N2 ? rowPlan : make_shared<const FFTPlan<T>>(N2);
+
+            twiddles.resize(N);
+            pool.parallelFor(N2, [&](size_t begin, size_t end) {
+                for (size_t n2 = begin; n2 < end; ++n2) {
+                    for (size_t k1 = 0; k1 < N1; ++k1) {
+                        double angle = -2 * M_PI * double((n2 * k1) % N) / N;
+                        twiddles[n2 * N1 + k1] = Cpx(T(cos(angle)), T(sin(angle)));
+                    }
+                }
+            });
+        } catch (const exception& e) {
+            cerr << "Ошибка при построении параллельного плана БПФ: " << e.what() << endl;
+            throw;
+        }
+    }
+
+    size_t size() const { return N; }
+
+    void execute(Array &x) const {
+        if (x.size() != N) {
+            throw runtime_error("Размер массива не совпадает с размером плана БПФ");
+        }
+        if (fullPlan) {
+            fullPlan->execute(x);
+            return;
+        }
+
+        Cpx* a = x.data();
+        ScratchBuffer<T> scratch(ScratchParallel, N, scratchPool);
+        Cpx* s = scratch.data();
+
+        transpose(a, s, N1, N2, pool);
+        pool.parallelFor(N2, [&](size_t begin, size_t end) {
+            for (size_t n2 = begin; n2 < end; ++n2) {
+                Cpx* row = s + n2 * N1;
+                const Cpx* w = &twiddles[n2 * N1];
+                rowPlan->execute(row);
+                for (size_t k1 = 0; k1 < N1; ++k1) {
+                    row[k1] *= w[k1];
+                }
+            }
+        });
+
+        transpose(s, a, N2, N1, pool);
+        pool.parallelFor(N1, [&](size_t begin, size_t end) {
+            for (size_t k1 = begin; k1 < end; ++k1) {
+                colPlan->execute(a + k1 * N2);
+            }
+        });
+
+        transpose(a, s, N1, N2, pool);
+        pool.parallelFor(N, [&](size_t begin, size_t end) {
+            copy(s + begin, s + end, a + begin);
+        });
+    }
+};
+
+// Пакетное БПФ: кадры одного размера распределяются по потокам пула,
+// план строится один раз и используется всеми потоками
+template<typename T>
+void fft_batch(const FFTPlan<T> &plan, vector<vector<complex<T>>> &frames, ThreadPool &pool) {
+    for (const auto &frame : frames) {
+        if (frame.size() != plan.size()) {
+            throw runtime_error("Размер кадра не совпадает с размером плана БПФ");
+        }
+    }
+    pool.parallelFor(frames.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            plan.execute(frames[i].data());
+        }
+    });
+}
+
+template<typename T>
+void fft_batch(vector<vector<complex<T>>> &frames) {
+    try {
+        if (frames.empty() || frames[0].empty()) {
+            throw runtime_error("Входной массив пуст");
+        }
+        FFTPlan<T> plan(frames[0].size());
+        fft_batch(plan, frames, defaultThreadPool());
+    } catch (const exception& e) {
+        cerr << "Ошибка в функции пакетного FFT: " << e.what() << endl;
+        throw;
+    }
+}
+
+// Кэш планов действительного БПФ: у каждого потока свой, план для размера строится один раз
+template<typename T>
+const RealFFTPlan<T>& cachedRealPlan(size_t n) {
+    thread_local map<size_t, shared_ptr<const RealFFTPlan<T>>> plans;
+    auto &plan = plans[n];
+    if (!plan) {
+        plan = make_shared<const RealFFTPlan<T>>(n);
+    }
+    return *plan;
+}
+
+// Метод вычисления свертки
+enum class ConvolutionMethod { Auto, Direct, OverlapAdd, OverlapSave };
+
+// Быстрая свертка действительного сигнала с фиксированным ядром.
+// Короткие ядра сворачиваются напрямую, длинные - через БПФ блоками размера L
+// (overlap-add или overlap-save). Метод и L выбираются по модели стоимости.
+// Спектры ядра для каждого L, планы и рабочие буферы сохраняются между вызовами,
+// поэтому один объект Convolver выгодно использовать для многих сигналов
+template<typename T = double>
+class Convolver {
+public:
+    typedef complex<T> Cpx;
+
+private:
+    vector<T> kernel;
+    map<size_t, vector<Cpx>> kernelSpectra; // Спектр ядра, дополненного нулями до L
+    vector<T> block;                        // Блок входа длины L
+    vector<Cpx> spectrum;                   // Спектр блока
+    vector<T> circular;                     // Циклическая свертка блока с ядром
+
+    // Оценка числа операций: прямая свертка - 2 операции на умножение-сложение,
+    // действительное БПФ размера L - около 2.5*L*log2(L), умножение спектров - 6 на бин
+    static double fftCost(size_t L) {
+        return 2.5 * double(L) * log2(double(L));
+    }
+
+public:
+    explicit Convolver(const vector<T> &kernelValues) : kernel(kernelValues) {
+        if (kernel.empty()) {
+            throw runtime_error("Ядро свертки пусто");
+        }
+    }
+
+    size_t kernelSize() const { return kernel.size(); }
+
+    // Выбор метода и размера блока L для сигнала длины n
+    ConvolutionMethod choose(size_t n, size_t &bestL) const {
+        size_t M = kernel.size();
+        size_t outLen = n + M - 1;
+        double best = 2.0 * double(n) * double(M);
+        ConvolutionMethod method = ConvolutionMethod::Direct;
+        bestL = 0;
+
+        size_t L = 2;
+        while (L < 2 * M) {
+            L <<= 1;
+        }
+        for (;; L <<= 1) {
+            size_t B = L - M + 1;
+            double blocks = double((outLen + B - 1) / B);
+            double cost = blocks * (2 * fftCost(L) + 6.0 * (L / 2 + 1));
+            if (cost < best) {
+                best = cost;
+                bestL = L;
+                method = ConvolutionMethod::OverlapSave;
+            }
+            if (B >= outLen) {
+                break;
+            }
+        }
+        return method;
+    }
+
+    // Полная линейная свертка: out длины n + M - 1
+    void process(const vector<T> &signal, vector<T> &out, ConvolutionMethod method = ConvolutionMethod::Auto) {
+        if (signal.empty()) {
+            throw runtime_error("Входной массив пуст");
+        }
+        size_t L = 0;
+        ConvolutionMethod chosen = choose(signal.size(), L);
+        if (method == ConvolutionMethod::Auto) {
+            method = chosen;
+        } else if (method != ConvolutionMethod::Direct && L == 0) {
+            // Явно запрошен метод через БПФ: берем наименьший допустимый размер блока
+            L = 2;
+            while (L < 2 * kernel.size()) {
+                L <<= 1;
+            }
+        }
+
+        out.assign(signal.size() + kernel.size() - 1, T(0));
+        switch (method) {
+        case ConvolutionMethod::Direct: direct(signal, out); break;
+        case ConvolutionMethod::OverlapAdd: overlapAdd(signal, out, L); break;
+        default: overlapSave(signal, out, L); break;
+        }
+    }
+
+private:
+    // Прямая свертка: для каждого отсчета ядра внутренний цикл по сигналу векторизуется
+    void direct(const vector<T> &signal, vector<T> &out) const {
+        size_t n = signal.size();
+        for (size_t k = 0; k < kernel.size(); ++k) {
+            T h = kernel[k];
+            T* dst = out.data() + k;
+            const T* src = signal.data();
+            for (size_t i = 0; i < n; ++i) {
+                dst[i] += h * src[i];
+            }
+        }
+    }
+
+    const vector<Cpx>& kernelSpectrum(size_t L) {
+        vector<Cpx> &H = kernelSpectra[L];
+        if (H.empty()) {
+            vector<T> padded(L, T(0));
+            copy(kernel.begin(), kernel.end(), padded.begin());
+            cachedRealPlan<T>(L).forward(padded, H);
+        }
+        return H;
+    }
+
+    // Циклическая свертка текущего блока с ядром (результат в circular)
+    void convolveBlock(size_t L, const vector<Cpx> &H) {
+        const RealFFTPlan<T> &plan = cachedRealPlan<T>(L);
+        plan.forward(block, spectrum);
+        for (size_t k = 0; k < spectrum.size(); ++k) {
+            spectrum[k] *= H[k];
+        }
+        plan.inverse(spectrum, circular);
+    }
+
+    // Overlap-add: блоки по B = L - M + 1 отсчетов, хвосты длины M - 1 складываются
+    void overlapAdd(const vector<T> &signal, vector<T> &out, size_t L) {
+        size_t n = signal.size(), M = kernel.size(), B = L - M + 1;
+        const vector<Cpx> &H = kernelSpectrum(L);
+        block.resize(L);
+        for (size_t start = 0; start < n; start += B) {
+            size_t len = min(B, n - start);
+            copy(signal.begin() + start, signal.begin() + start + len, block.begin());
+            fill(block.begin() + len, block.end(), T(0));
+            convolveBlock(L, H);
+            size_t produced = min(len + M - 1, out.size() - start);
+            for (size_t i = 0; i < produced; ++i) {
+                out[start + i] += circular[i];
+            }
+        }
+    }
+
+    // Overlap-save: блоки длины L перекрываются на M - 1 отсчетов,
+    // первые M - 1 отсчетов циклической свертки (с заворотом) отбрасываются
+    void overlapSave(const vector<T> &signal, vector<T> &out, size_t L) {
+        size_t n = signal.size(), M = kernel.size(), B = L - M + 1;
+        const vector<Cpx> &H = kernelSpectrum(L);
+        block.resize(L);
+        for (size_t start = 0; start < out.size(); start += B) {
+            // Блок покрывает отсчеты сигнала [start - (M-1), start - (M-1) + L)
+            for (size_t i = 0; i < L; ++i) {
+                size_t idx = start + i;
+                block[i] = (idx >= M - 1 && idx - (M - 1) < n) ? signal[idx - (M - 1)] : T(0);
+            }
+            convolveBlock(L, H);
+            size_t produced = min(B, out.size() - start);
+            copy(circular.begin() + (M - 1), circular.begin() + (M - 1) + produced, out.begin() + start);
+        }
+    }
+};
+
+// Линейная свертка сигнала с ядром: результат длины N + M - 1
+template<typename T>
+vector<T> convolve(const vector<T> &signal, const vector<T> &kernel,
+                   ConvolutionMethod method = ConvolutionMethod::Auto) {
+    try {
+        Convolver<T> conv(kernel);
+        vector<T> out;
+        conv.process(signal, out, method);
+        return out;
+    } catch (const exception& e) {
+        cerr << "Ошибка в функции свертки: " << e.what() << endl;
+        throw;
+    }
+}
+
+// Взаимная корреляция: r[j] = sum(signal[n + lag] * kernel[n]), lag = j - (M - 1),
+// то есть сдвиги от -(M-1) до N-1. Вычисляется как свертка с развернутым ядром
+template<typename T>
+vector<T> correlate(const vector<T> &signal, const vector<T> &kernel,
+                    ConvolutionMethod method = ConvolutionMethod::Auto) {
+    try {
+        vector<T> reversed(kernel.rbegin(), kernel.rend());
+        Convolver<T> conv(reversed);
+        vector<T> out;
+        conv.process(signal, out, method);
+        return out;
+    } catch (const exception& e) {
+        cerr << "Ошибка в функции корреляции: " << e.what() << endl;
+        throw;
+    }
+}
+
 // Функция для вычисления модуля спектра
 vector<double> computeMagnitude(const CArray &x) {
     try {
@@ -67,6 +1532,23 @@ vector<double> computeMagnitude(const CArray &x) {
     }
 }
 
+// Функция для вычисления модуля спектра в раздельном формате (векторизованная)
+template<typename T>
+vector<T> computeMagnitude(const SplitArray<T> &x) {
+    try {
+        if (x.size() == 0) {
+            throw runtime_error("Входной массив пуст");
+        }
+
+        vector<T> magnitude(x.size());
+        fftKernels<T>().magnitude(x.re.data(), x.im.data(), magnitude.data(), x.size());
+        return magnitude;
+    } catch (const exception& e) {
+        cerr << "Ошибка при вычислении модуля спектра: " << e.what() << endl;
+        throw;
+    }
+}
+
 // Функция для вывода массива комплексных чисел
 void printArray(const CArray &x) {
     try {
@@ -97,13 +1579,605 @@ void printMagnitude(const vector<double> &magnitude) {
     }
 }
 
-int main() {
+// Файл, отображенный в память только для чтения. Страницы подгружаются
+// операционной системой по мере обращения, поэтому размер файла не ограничен
+// объемом оперативной памяти
+class MappedFile {
+private:
+    const char* ptr = nullptr;
+    size_t length = 0;
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = NULL;
+#else
+    int fd = -1;
+#endif
+
+public:
+    explicit MappedFile(const string &path) {
+#ifdef _WIN32
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                           FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+        if (file == INVALID_HANDLE_VALUE) {
+            throw runtime_error("Не удалось открыть файл: " + path);
+        }
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize)) {
+            CloseHandle(file);
+            throw runtime_error("Не удалось определить размер файла: " + path);
+        }
+        length = size_t(fileSize.QuadPart);
+        if (length == 0) {
+            return;
+        }
+        mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mapping == NULL) {
+            CloseHandle(file);
+            throw runtime_error("Не удалось отобразить файл в память: " + path);
+        }
+        ptr = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        if (ptr == nullptr) {
+            CloseHandle(mapping);
+            CloseHandle(file);
+            throw runtime_error("Не удалось отобразить файл в память: " + path);
+        }
+#else
+        fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw runtime_error("Не удалось открыть файл: " + path);
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            close(fd);
+            throw runtime_error("Не удалось определить размер файла: " + path);
+        }
+        length = size_t(st.st_size);
+        if (length == 0) {
+            return;
+        }
+        void* p = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+            close(fd);
+            throw runtime_error("Не удалось отобразить файл в память: " + path);
+        }
+        ptr = static_cast<const char*>(p);
+        madvise(p, length, MADV_SEQUENTIAL);
+#endif
+    }
+
+    ~MappedFile() {
+#ifdef _WIN32
+        if (ptr != nullptr) {
+            UnmapViewOfFile(ptr);
+        }
+        if (mapping != NULL) {
+            CloseHandle(mapping);
+        }
+        if (file != INVALID_HANDLE_VALUE) {
+            CloseHandle(file);
+        }
+#else
+        if (ptr != nullptr) {
+            munmap(const_cast<char*>(ptr), length);
+        }
+        if (fd >= 0) {
+            close(fd);
+        }
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const { return ptr; }
+    size_t size() const { return length; }
+
+    // Подсказка системе, что байты [0, offset) больше не нужны и их страницы
+    // можно вытеснить (на Windows чистые страницы вытесняются системой сама)
+    void release(size_t offset) const {
+#ifndef _WIN32
+        long page = sysconf(_SC_PAGESIZE);
+        size_t end = offset / page * page;
+        if (ptr != nullptr && end > 0) {
+            madvise(const_cast<char*>(ptr), end, MADV_DONTNEED);
+        }
+#else
+        (void)offset;
+#endif
+    }
+};
+
+// Оконные функции для STFT
+enum class WindowType { Rectangular, Hann, Hamming };
+
+// Формат отсчетов во входном файле
+enum class SampleFormat { Float32, Float64 };
+
+// Потоковое оконное преобразование Фурье (STFT). Отсчеты читаются из файла,
+// отображенного в память, кадр длины frameSize сдвигается на hop отсчетов
+// (перекрытие = frameSize - hop), умножается на окно и проходит через план
+// действительного БПФ; модуль спектра (frameSize/2+1 бинов) сразу пишется в выходной поток.
+// Память ограничена буферами одного кадра независимо от размера входа
+class STFTProcessor {
+private:
+    size_t frameSize, hop;
+    vector<double> window;
+    RealFFTPlan<> plan;
+    vector<double> frame;       // Текущий кадр после умножения на окно
+    CArray spectrum;            // Половинный спектр кадра
+    vector<double> magnitude;   // Модуль спектра кадра
+
+public:
+    STFTProcessor(size_t frameLength, size_t hopLength, WindowType type)
+        : frameSize(frameLength), hop(hopLength), window(frameLength), plan(frameLength),
+          frame(frameLength), spectrum(frameLength / 2 + 1), magnitude(frameLength / 2 + 1) {
+        if (hop == 0 || hop > frameSize) {
+            throw runtime_error("Шаг STFT должен быть в диапазоне от 1 до длины кадра");
+        }
+        // Периодические окна: сумма сдвинутых окон постоянна при стандартных перекрытиях
+        for (size_t n = 0; n < frameSize; ++n) {
+            double phase = 2 * M_PI * n / frameSize;
+            switch (type) {
+            case WindowType::Rectangular: window[n] = 1.0; break;
+            case WindowType::Hann: window[n] = 0.5 - 0.5 * cos(phase); break;
+            case WindowType::Hamming: window[n] = 0.54 - 0.46 * cos(phase); break;
+            }
+        }
+    }
+
+    size_t bins() const { return frameSize / 2 + 1; }
+
+    // Обработка всего файла; возвращает число кадров.
+    // Последний неполный кадр дополняется нулями
+    size_t process(const MappedFile &input, SampleFormat format, ostream &out, bool text) {
+        size_t sampleBytes = format == SampleFormat::Float32 ? sizeof(float) : sizeof(double);
+        size_t total = input.size() / sampleBytes;
+        if (total == 0) {
+            throw runtime_error("Входной файл не содержит отсчетов");
+        }
+        const char* base = input.data();
+        size_t frames = total <= frameSize ? 1 : 1 + (total - frameSize + hop - 1) / hop;
+        const size_t releaseStep = size_t(16) << 20;
+        size_t released = 0;
+
+        for (size_t f = 0; f < frames; ++f) {
+            size_t start = f * hop;
+            size_t available = min(frameSize, total - start);
+            for (size_t n = 0; n < available; ++n) {
+                const char* p = base + (start + n) * sampleBytes;
+                double sample;
+                if (format == SampleFormat::Float32) {
+                    float v;
+                    memcpy(&v, p, sizeof(v));
+                    sample = v;
+                } else {
+                    memcpy(&sample, p, sizeof(sample));
+                }
+                frame[n] = sample * window[n];
+            }
+            fill(frame.begin() + available, frame.end(), 0.0);
+
+            plan.forward(frame, spectrum);
+            for (size_t k = 0; k < spectrum.size(); ++k) {
+                magnitude[k] = abs(spectrum[k]);
+            }
+
+            if (text) {
+                for (size_t k = 0; k < magnitude.size(); ++k) {
+                    out << magnitude[k] << (k + 1 < magnitude.size() ? ' ' : '\n');
+                }
+            } else {
+                out.write(reinterpret_cast<const char*>(magnitude.data()), magnitude.size() * sizeof(double));
+            }
+            if (!out) {
+                throw runtime_error("Ошибка записи спектра в выходной файл");
+            }
+
+            // Отсчеты до начала следующего кадра больше не понадобятся;
+            // страницы освобождаются порциями, чтобы не делать системный вызов на каждый кадр
+            size_t consumed = (start + hop) * sampleBytes;
+            if (consumed - released >= releaseStep) {
+                input.release(consumed);
+                released = consumed;
+            }
+        }
+        return frames;
+    }
+};
+
+// Режим STFT: ./fft --stft <вход> <выход> [--frame N] [--hop H | --overlap V]
+//                   [--window hann|hamming|rect] [--format f32|f64] [--text]
+int runSTFT(int argc, char* argv[]) {
+    using namespace std::chrono;
+    if (argc < 4) {
+        throw runtime_error("Использование: --stft <вход> <выход> [--frame N] [--hop H | --overlap V] "
+                            "[--window hann|hamming|rect] [--format f32|f64] [--text]");
+    }
+    string inputPath = argv[2], outputPath = argv[3];
+    size_t frameSize = 1024, hop = 0, overlap = 0;
+    bool overlapSet = false, text = false;
+    WindowType window = WindowType::Hann;
+    SampleFormat format = SampleFormat::Float32;
+
+    for (int i = 4; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--text") {
+            text = true;
+        } else if (i + 1 < argc) {
+            string value = argv[++i];
+            if (arg == "--frame") {
+                frameSize = stoul(value);
+            } else if (arg == "--hop") {
+                hop = stoul(value);
+            } else if (arg == "--overlap") {
+                overlap = stoul(value);
+                overlapSet = true;
+            } else if (arg == "--window") {
+                if (value == "hann") window = WindowType::Hann;
+                else if (value == "hamming") window = WindowType::Hamming;
+                else if (value == "rect") window = WindowType::Rectangular;
+                else throw runtime_error("Неизвестное окно: " + value);
+            } else if (arg == "--format") {
+                if (value == "f32") format = SampleFormat::Float32;
+                else if (value == "f64") format = SampleFormat::Float64;
+                else throw runtime_error("Неизвестный формат отсчетов: " + value);
+            } else {
+                throw runtime_error("Неизвестный параметр: " + arg);
+            }
+        } else {
+            throw runtime_error("Нет значения после " + arg);
+        }
+    }
+    if (overlapSet) {
+        if (overlap >= frameSize) {
+            throw runtime_error("Перекрытие должно быть меньше длины кадра");
+        }
+        hop = frameSize - overlap;
+    } else if (hop == 0) {
+        hop = frameSize / 4; // По умолчанию перекрытие 75%
+    }
+
+    MappedFile input(inputPath);
+    ofstream output(outputPath, text ? ios::out : ios::out | ios::binary);
+    if (!output) {
+        throw runtime_error("Не удалось открыть выходной файл: " + outputPath);
+    }
+
+    STFTProcessor stft(frameSize, hop, window);
+    auto t0 = high_resolution_clock::now();
+    size_t frames = stft.process(input, format, output, text);
+    output.close();
+    auto t1 = high_resolution_clock::now();
+
+    double sec = duration<double>(t1 - t0).count();
+    cout << "Кадров: " << frames << ", бинов в кадре: " << stft.bins() << ", шаг: " << hop << endl;
+    cout << "Время: " << sec << " с, " << input.size() / sec / 1e6 << " МБ/с" << endl;
+    return 0;
+}
+
+// Бенчмарк: сравнение рекурсивного БПФ и плана на размерах от 2^10 до 2^24
+void runBenchmark() {
+    using namespace std::chrono;
+    cout << "Ядра SIMD: " << fftKernels<double>().name << endl;
+    cout << "log2(N)  рекурсия, мс  план, мс  SoA, мс  ускорение (план / SoA)  макс. расхождение" << endl;
+    for (int p = 10; p <= 24; ++p) {
+        size_t N = size_t(1) << p;
+        CArray input(N);
+        for (size_t i = 0; i < N; ++i) {
+            input[i] = Complex(sin(0.001 * i), cos(0.003 * i));
+        }
+
+        CArray a = input;
+        auto t0 = high_resolution_clock::now();
+        fftRecursive(a);
+        auto t1 = high_resolution_clock::now();
+
+        // План строится один раз, время измеряется только для преобразования
+        FFTPlan plan(N);
+        CArray b = input;
+        auto t2 = high_resolution_clock::now();
+        plan.execute(b);
+        auto t3 = high_resolution_clock::now();
+
+        // Тот же план на данных в раздельном формате с SIMD-ядрами
+        SplitArray c(input);
+        auto t4 = high_resolution_clock::now();
+        plan.execute(c);
+        auto t5 = high_resolution_clock::now();
+
+        double maxDiff = 0;
+        for (size_t i = 0; i < N; ++i) {
+            maxDiff = max(maxDiff, abs(a[i] - b[i]));
+            maxDiff = max(maxDiff, abs(a[i] - Complex(c.re[i], c.im[i])));
+        }
+
+        double msRec = duration<double, milli>(t1 - t0).count();
+        double msPlan = duration<double, milli>(t3 - t2).count();
+        double msSplit = duration<double, milli>(t5 - t4).count();
+        cout << p << "  " << msRec << "  " << msPlan << "  " << msSplit << "  "
+             << msRec / msPlan << "x / " << msRec / msSplit << "x  " << maxDiff << endl;
+    }
+}
+
+// Бенчмарк действительного БПФ против комплексного плана на тех же данных
+void runRealBenchmark() {
+    using namespace std::chrono;
+    cout << "log2(N)  комплексное, мс  RFFT, мс  ускорение  ошибка RFFT  ошибка IRFFT" << endl;
+    for (int p = 10; p <= 24; ++p) {
+        size_t N = size_t(1) << p;
+        vector<double> signal(N);
+        for (size_t i = 0; i < N; ++i) {
+            signal[i] = sin(0.001 * i) + 0.5 * cos(0.03 * i);
+        }
+
+        FFTPlan plan(N);
+        CArray full(signal.begin(), signal.end());
+        auto t0 = high_resolution_clock::now();
+        plan.execute(full);
+        auto t1 = high_resolution_clock::now();
+
+        RealFFTPlan rplan(N);
+        CArray spectrum;
+        rplan.forward(signal, spectrum); // Прогрев: выделение памяти под спектр
+        auto t2 = high_resolution_clock::now();
+        rplan.forward(signal, spectrum);
+        auto t3 = high_resolution_clock::now();
+
+        double errForward = 0;
+        for (size_t k = 0; k <= N / 2; ++k) {
+            errForward = max(errForward, abs(full[k] - spectrum[k]));
+        }
+        vector<double> restored;
+        rplan.inverse(spectrum, restored);
+        double errInverse = 0;
+        for (size_t i = 0; i < N; ++i) {
+            errInverse = max(errInverse, fabs(restored[i] - signal[i]));
+        }
+
+        double msFull = duration<double, milli>(t1 - t0).count();
+        double msReal = duration<double, milli>(t3 - t2).count();
+        cout << p << "  " << msFull << "  " << msReal << "  " << msFull / msReal << "x  "
+             << errForward << "  " << errInverse << endl;
+    }
+}
+
+// Бенчмарк произвольных размеров: время на N*log2(N) должно оставаться примерно постоянным
+void runArbitraryBenchmark() {
+    using namespace std::chrono;
+    const char* kindNames[] = {"radix-2", "смешанное основание", "Блюстейн", "кодлет"};
+    cout << "N  алгоритм  мс  нс/(N*log2 N)  ошибка (16 бинов)" << endl;
+    for (size_t N : {64, 1000, 1009, 1024, 1500, 48000, 65536, 65537, 1000000, 999983, 1048576}) {
+        CArray input(N);
+        for (size_t i = 0; i < N; ++i) {
+            input[i] = Complex(sin(0.001 * i), cos(0.003 * i));
+        }
+
+        FFTPlan plan(N);
+        CArray x = input;
+        plan.execute(x); // Прогрев: выделение временных буферов
+        x = input;
+        auto t0 = high_resolution_clock::now();
+        plan.execute(x);
+        auto t1 = high_resolution_clock::now();
+
+        // Проверка по прямой формуле ДПФ на нескольких бинах
+        double err = 0;
+        for (size_t k = 0; k < N; k += N / 16 + 1) {
+            Complex acc = 0;
+            for (size_t n = 0; n < N; ++n) {
+                acc += input[n] * polar(1.0, -2 * M_PI * double((n * k) % N) / N);
+            }
+            err = max(err, abs(acc - x[k]) / (1 + abs(acc)));
+        }
+
+        double ms = duration<double, milli>(t1 - t0).count();
+        cout << N << "  " << kindNames[int(plan.type())] << "  " << ms << "  "
+             << ms * 1e6 / (N * log2(double(N))) << "  " << err << endl;
+    }
+}
+
+// Бенчмарк точности: float против double на SoA-пути
+void runPrecisionBenchmark() {
+    using namespace std::chrono;
+    cout << "Ядра SIMD (float): " << fftKernels<float>().name << endl;
+    cout << "log2(N)  double, мс  float, мс  ускорение  отн. ошибка float" << endl;
+    for (int p = 10; p <= 22; p += 2) {
+        size_t N = size_t(1) << p;
+        SplitArray<double> xd(N);
+        SplitArray<float> xf(N);
+        for (size_t i = 0; i < N; ++i) {
+            xd.re[i] = sin(0.001 * i);
+            xd.im[i] = cos(0.003 * i);
+            xf.re[i] = float(xd.re[i]);
+            xf.im[i] = float(xd.im[i]);
+        }
+        FFTPlan<double> pd(N);
+        FFTPlan<float> pf(N);
+
+        auto t0 = high_resolution_clock::now();
+        pd.execute(xd);
+        auto t1 = high_resolution_clock::now();
+        pf.execute(xf);
+        auto t2 = high_resolution_clock::now();
+
+        double err = 0, norm = 0;
+        for (size_t i = 0; i < N; ++i) {
+            err = max(err, abs(Complex(xd.re[i] - xf.re[i], xd.im[i] - xf.im[i])));
+            norm = max(norm, abs(Complex(xd.re[i], xd.im[i])));
+        }
+        double msD = duration<double, milli>(t1 - t0).count();
+        double msF = duration<double, milli>(t2 - t1).count();
+        cout << p << "  " << msD << "  " << msF << "  " << msD / msF << "x  " << err / norm << endl;
+    }
+}
+
+// Бенчмарк кодлетов: миллион маленьких преобразований
+template<size_t N>
+void benchCodelet() {
+    using namespace std::chrono;
+    const size_t count = 1000000;
+    CArray x(N), y(N), z(N);
+    for (size_t i = 0; i < N; ++i) {
+        x[i] = y[i] = z[i] = Complex(double(i), 0);
+    }
+    FFTPlan<double> loopPlan(N, false), codeletPlan(N);
+
+    auto t0 = high_resolution_clock::now();
+    for (size_t r = 0; r < count; ++r) {
+        loopPlan.execute(x.data());
+        x[0] *= 1e-3; // Не дает значениям расти и не дает компилятору выбросить цикл
+    }
+    auto t1 = high_resolution_clock::now();
+    for (size_t r = 0; r < count; ++r) {
+        codeletPlan.execute(y.data());
+        y[0] *= 1e-3;
+    }
+    auto t2 = high_resolution_clock::now();
+    for (size_t r = 0; r < count; ++r) {
+        fftFixed<N>(z.data());
+        z[0] *= 1e-3;
+    }
+    auto t3 = high_resolution_clock::now();
+
+    double diff = 0;
+    for (size_t i = 0; i < N; ++i) {
+        diff = max(diff, abs(x[i] - z[i]) / (1 + abs(x[i])));
+    }
+    double nsLoop = duration<double, nano>(t1 - t0).count() / count;
+    double nsPlan = duration<double, nano>(t2 - t1).count() / count;
+    double nsFixed = duration<double, nano>(t3 - t2).count() / count;
+    cout << N << "  " << nsLoop << "  " << nsPlan << "  " << nsFixed << "  "
+         << nsLoop / nsFixed << "x  " << diff << endl;
+}
+
+void runCodeletBenchmark() {
+    cout << "N  циклы, нс  план с кодлетом, нс  fftFixed, нс  ускорение  расхождение" << endl;
+    benchCodelet<8>();
+    benchCodelet<16>();
+    benchCodelet<32>();
+    benchCodelet<64>();
+}
+
+// Бенчмарк свертки: прямой метод против выбранного моделью стоимости
+void runConvolutionBenchmark() {
+    using namespace std::chrono;
+    const char* methodNames[] = {"auto", "прямой", "overlap-add", "overlap-save"};
+    const size_t N = size_t(1) << 18;
+    vector<double> signal(N);
+    for (size_t i = 0; i < N; ++i) {
+        signal[i] = sin(0.01 * i) + 0.3 * cos(0.17 * i);
+    }
+    cout << "M  выбран  L  прямой, мс  выбранный, мс  ускорение  ошибка" << endl;
+    for (size_t M : {4, 16, 64, 256, 1024, 4096}) {
+        vector<double> kernel(M);
+        for (size_t k = 0; k < M; ++k) {
+            kernel[k] = exp(-double(k) / M) * cos(0.05 * k);
+        }
+        Convolver<double> conv(kernel);
+        size_t L = 0;
+        ConvolutionMethod method = conv.choose(N, L);
+
+        vector<double> direct, fast;
+        auto t0 = high_resolution_clock::now();
+        conv.process(signal, direct, ConvolutionMethod::Direct);
+        auto t1 = high_resolution_clock::now();
+        conv.process(signal, fast); // Прогрев: спектр ядра и планы
+        auto t2 = high_resolution_clock::now();
+        conv.process(signal, fast);
+        auto t3 = high_resolution_clock::now();
+
+        double err = 0;
+        for (size_t i = 0; i < direct.size(); ++i) {
+            err = max(err, fabs(direct[i] - fast[i]));
+        }
+        double msDirect = duration<double, milli>(t1 - t0).count();
+        double msFast = duration<double, milli>(t3 - t2).count();
+        cout << M << "  " << methodNames[int(method)] << "  " << L << "  " << msDirect << "  "
+             << msFast << "  " << msDirect / msFast << "x  " << err << endl;
+    }
+}
+
+// Бенчмарк многопоточности: одно большое БПФ и пакет кадров на 1..64 потоках
+void runParallelBenchmark() {
+    using namespace std::chrono;
+    const size_t bigN = size_t(1) << 22;
+    const size_t frameN = 1024, frameCount = 8192;
+
+    CArray big(bigN);
+    for (size_t i = 0; i < bigN; ++i) {
+        big[i] = Complex(sin(0.001 * i), cos(0.003 * i));
+    }
+    CArray reference = big;
+    FFTPlan(bigN).execute(reference);
+
+    vector<CArray> frames(frameCount, CArray(frameN));
+    for (size_t f = 0; f < frameCount; ++f) {
+        for (size_t i = 0; i < frameN; ++i) {
+            frames[f][i] = Complex(sin(0.01 * (i + f)), 0);
+        }
+    }
+    FFTPlan framePlan(frameN);
+
+    cout << "Ядер: " << thread::hardware_concurrency() << endl;
+    cout << "потоки  БПФ 2^22, мс  ускорение  пакет " << frameCount << "x" << frameN
+         << ", мс  ускорение  ошибка" << endl;
+    double baseBig = 0, baseBatch = 0;
+    for (size_t threads : {1, 2, 4, 8, 16, 32, 64}) {
+        ThreadPool pool(threads);
+        ParallelFFTPlan plan(bigN, pool);
+
+        CArray x = big;
+        plan.execute(x); // Прогрев
+        x = big;
+        auto t0 = high_resolution_clock::now();
+        plan.execute(x);
+        auto t1 = high_resolution_clock::now();
+
+        vector<CArray> batch = frames;
+        auto t2 = high_resolution_clock::now();
+        fft_batch(framePlan, batch, pool);
+        auto t3 = high_resolution_clock::now();
+
+        double err = 0;
+        for (size_t i = 0; i < bigN; ++i) {
+            err = max(err, abs(x[i] - reference[i]));
+        }
+
+        double msBig = duration<double, milli>(t1 - t0).count();
+        double msBatch = duration<double, milli>(t3 - t2).count();
+        if (threads == 1) {
+            baseBig = msBig;
+            baseBatch = msBatch;
+        }
+        cout << threads << "  " << msBig << "  " << baseBig / msBig << "x  "
+             << msBatch << "  " << baseBatch / msBatch << "x  " << err << endl;
+    }
+}
+
+int main(int argc, char* argv[]) {
     try {
         // Устанавливаем кодовую страницу консоли на UTF-8
         if (!SetConsoleOutputCP(CP_UTF8)) {
             throw runtime_error("Не удалось установить кодировку UTF-8");
         }
 
+        // Режим бенчмарка: ./fft --bench
+        if (argc > 1 && string(argv[1]) == "--bench") {
+            runBenchmark();
+            runRealBenchmark();
+            runArbitraryBenchmark();
+            runParallelBenchmark();
+            runPrecisionBenchmark();
+            runCodeletBenchmark();
+            runConvolutionBenchmark();
+            return 0;
+        }
+
+        // Потоковый STFT по файлу: ./fft --stft <вход> <выход> [параметры]
+        if (argc > 1 && string(argv[1]) == "--stft") {
+            return runSTFT(argc, argv);
+        }
+
         // Создаем массив комплексных чисел
         CArray data = {
             {0, 0}, {1, 0}, {2, 0}, {3, 0},
@@ -124,6 +2198,14 @@ int main() {
         cout << "Модуль спектра:" << endl;
         printMagnitude(magnitude);
 
+        // Те же данные как действительный сигнал: только N/2+1 неизбыточных бинов
+        vector<double> signal = {0, 1, 2, 3, 4, 5, 6, 7};
+        CArray halfSpectrum = rfft(signal);
+        cout << "Результат RFFT (N/2+1 бинов):" << endl;
+        printArray(halfSpectrum);
+        cout << "Модуль половинного спектра:" << endl;
+        printMagnitude(computeMagnitude(halfSpectrum));
+
         return 0;
     } catch (const exception& e) {
         cerr << "Критическая ошибка: " << e.what() << endl;
@@ -2,12 +2,13 @@
 #include <fstream>
 #include <vector>
 #include <iomanip>
+#include <cmath>
+#include <algorithm>
+#include "heat_engine.h"
 #include <windows.h> // Подключение библиотеки для работы с Windows API (нужно для установки кодировки UTF-8 в PowerShel или CMD)
 
 using namespace std;
 
-const int mf = 500;
-
 // Класс для вектора
 class Vector {
 private:
@@ -57,41 +58,27 @@ void initializeTemperature(vector<double> &T, int N, double T0) {
     }
 }
 
-// Функция для интегрирования нестационарного уравнения теплопроводности
-void integrateHeatEquation(vector<double> &T, int N, double lamda, double ro, double c, double h, double tau, double Tl, double Tr, double t_end) {
-    vector<double> alfa(mf), beta(mf);
-    double time = 0;
-
-    while (time < t_end) {
-        time += tau;
-
-        // Начальные прогоночные коэффициенты
-        alfa[0] = 0.0;
-        beta[0] = Tl;
-
-        // Определение прогоночных коэффициентов
-        for (int i = 1; i < N - 1; i++) {
-            double ai = lamda / (h * h);
-            double bi = 2.0 * lamda / (h * h) + ro * c / tau;
-            double ci = lamda / (h * h);
-            double fi = -ro * c * T[i] / tau;
-
-            alfa[i] = ai / (bi - ci * alfa[i - 1]);
-            beta[i] = (ci * beta[i - 1] - fi) / (bi - ci * alfa[i - 1]);
-        }
-
-        // Температура на правой границе
-        T[N - 1] = Tr;
+// Функция для интегрирования нестационарного уравнения теплопроводности. Шаг tau постоянный,
+// поэтому матрица системы раскладывается один раз, а на каждом шаге выполняются только подстановки
+AdaptiveStats integrateHeatEquation(vector<double> &T, int N, double lamda, double ro, double c, double h, double tau, double Tl, double Tr, double t_end) {
+    HeatEngine1D engine(N, h, lamda, ro, c, Tl, Tr);
+    return integrateFixed(T, tau, t_end, [&engine](const double *from, double dt, double *to) {
+        engine.step(from, dt, to);
+    });
+}
 
-        // Определение поля температуры
-        for (int i = N - 2; i >= 0; i--) {
-            T[i] = alfa[i] * T[i + 1] + beta[i];
-        }
-    }
+// Функция для интегрирования с адаптивным шагом по времени (integrateAdaptive из heat_engine.h):
+// ошибка шага не превышает tolerance, температуры в моменты outputTimes записываются в snapshots
+AdaptiveStats integrateHeatEquationAdaptive(vector<double> &T, int N, double lamda, double ro, double c, double h, double tau, double Tl, double Tr, double t_end,
+                                            double tolerance, const vector<double> &outputTimes, vector<vector<double>> &snapshots) {
+    HeatEngine1D engine(N, h, lamda, ro, c, Tl, Tr);
+    return integrateAdaptive(T, tau, t_end, tolerance, outputTimes, snapshots, [&engine](const double *from, double dt, double *to) {
+        engine.step(from, dt, to);
+    });
 }
 
-// Функция для вывода результатов в файл
-void outputResults(const vector<double> &T, int N, double L, double lamda, double ro, double c, double T0, double Tl, double Tr, double h, double tau, double t_end) {
+// Функция для вывода результатов в файл; шаг по времени берется из статистики расчета
+void outputResults(const vector<double> &T, int N, double L, double lamda, double ro, double c, double T0, double Tl, double Tr, double h, const AdaptiveStats &stats, double t_end) {
     ofstream f("res.txt");
     f << fixed << setprecision(4);
     f << "Толщина пластины L = " << L << endl;
@@ -103,7 +90,11 @@ void outputResults(const vector<double> &T, int N, double L, double lamda, doubl
     f << "Температура на границе x = 0, Tl = " << Tl << endl;
     f << "Температура на границе x = L, Tr = " << Tr << endl;
     f << "Результат получен с шагом по координате h = " << h << endl;
-    f << "Результат получен с шагом по времени tau = " << tau << endl;
+    if (stats.minStep == stats.maxStep) {
+        f << "Результат получен с шагом по времени tau = " << stats.maxStep << endl;
+    } else {
+        f << "Результат получен с адаптивным шагом по времени tau от " << stats.minStep << " до " << stats.maxStep << endl;
+    }
     f << "Температурное поле в момент времени t = " << t_end << endl;
     f.close();
 }
@@ -118,6 +109,25 @@ void outputTemperatureField(const vector<double> &T, int N, double h) {
     g.close();
 }
 
+// Функция для вывода температур в заданные моменты времени: столбец x и по столбцу на момент
+void outputSnapshots(const vector<vector<double>> &snapshots, const vector<double> &outputTimes, int N, double h) {
+    ofstream g("tempr_t.txt");
+    g << fixed << setprecision(3);
+    g << setw(6) << "x";
+    for (double t : outputTimes) {
+        g << "   " << setw(8) << t;
+    }
+    g << endl;
+    for (int i = 0; i < N; i++) {
+        g << setw(6) << h * i;
+        for (const vector<double> &snapshot : snapshots) {
+            g << "   " << setw(8) << snapshot[i];
+        }
+        g << endl;
+    }
+    g.close();
+}
+
 int main() {
     // Устанавливаем кодовую страницу консоли на UTF-8
     SetConsoleOutputCP(CP_UTF8);
@@ -126,23 +136,55 @@ int main() {
 
     // Ввод параметров
     inputParameters(N, t_end, L, lamda, ro, c, T0, Tl, Tr);
+    if (N < 3) {
+        cout << "Число узлов должно быть не меньше 3" << endl;
+        return 1;
+    }
+    double tolerance;
+    cout << "Введите допустимую погрешность шага по времени (0 - постоянный шаг t_end/100): ";
+    cin >> tolerance;
+    vector<double> outputTimes;
+    if (tolerance > 0) {
+        int count;
+        cout << "Введите число моментов времени для вывода (0 - только t_end): ";
+        cin >> count;
+        outputTimes.resize(max(count, 0));
+        for (double &t : outputTimes) {
+            cout << "Введите момент времени, t: ";
+            cin >> t;
+        }
+        sort(outputTimes.begin(), outputTimes.end());
+    }
 
     // Расчетный шаг по пространственной координате и времени
     double h = L / (N - 1);
     double tau = t_end / 100.0;
 
     // Вектор для температуры
-    vector<double> T(mf);
+    vector<double> T(N);
 
     // Инициализация температуры
     initializeTemperature(T, N, T0);
 
     // Интегрирование уравнения теплопроводности
-    integrateHeatEquation(T, N, lamda, ro, c, h, tau, Tl, Tr, t_end);
+    vector<vector<double>> snapshots;
+    AdaptiveStats stats;
+    if (tolerance > 0) {
+        stats = integrateHeatEquationAdaptive(T, N, lamda, ro, c, h, tau, Tl, Tr, t_end, tolerance, outputTimes, snapshots);
+        cout << "Шагов по времени: " << stats.accepted << " (отклонено: " << stats.rejected << "), прогонок: " << stats.sweeps << endl;
+        if (stats.steady) {
+            cout << "Стационарный режим достигнут при t = " << stats.finalTime << ", расчет остановлен" << endl;
+        }
+    } else {
+        stats = integrateHeatEquation(T, N, lamda, ro, c, h, tau, Tl, Tr, t_end);
+    }
 
     // Вывод результатов
-    outputResults(T, N, L, lamda, ro, c, T0, Tl, Tr, h, tau, t_end);
+    outputResults(T, N, L, lamda, ro, c, T0, Tl, Tr, h, stats, t_end);
     outputTemperatureField(T, N, h);
+    if (!outputTimes.empty()) {
+        outputSnapshots(snapshots, outputTimes, N, h);
+    }
 
     return 0;
 }
@@ -0,0 +1,272 @@
+// Общий расчетный модуль для 1.cpp и oopslau.cpp: неявная схема для уравнения
+// теплопроводности с заранее разложенной трехдиагональной матрицей
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+
+// Прогоночные коэффициенты для линии из n узлов с закрепленными концами. Матрица
+// (-a, 2a + m, -a) не зависит от температуры, поэтому ее LU-разложение считается один
+// раз: beta[i] = alpha[i] * beta[i-1] + weight[i] * f[i], где alpha[i] = a / d[i],
+// weight[i] = m / d[i], d[i] - знаменатель прогонки. В подстановках остаются только
+// умножения, а цепочка зависимостей между узлами - одно умножение-сложение
+struct SweepCoefficients {
+    double a = 0.0, m = 0.0;
+    std::vector<double> alpha, weight;
+
+    SweepCoefficients() = default;
+    SweepCoefficients(int n, double offDiagonal, double massOverTau)
+        : a(offDiagonal), m(massOverTau), alpha(n, 0.0), weight(n, 0.0) {
+        for (int i = 1; i < n - 1; ++i) {
+            double inverse = 1.0 / (2.0 * a + m - a * alpha[i - 1]);
+            alpha[i] = a * inverse;
+            weight[i] = m * inverse;
+        }
+    }
+};
+
+// Прогонка count соседних линий сразу: узел i линии l лежит в first[i * stride + l].
+// Внутренние циклы идут по линиям подряд в памяти и векторизуются; прогоночные
+// beta записываются на место правой части, отдельных буферов не нужно
+inline void sweepBlock(double* first, int64_t count, int n, ptrdiff_t stride, const SweepCoefficients& k) {
+    for (int i = 1; i < n - 1; ++i) {
+        double* __restrict row = first + i * stride;
+        const double* __restrict prev = row - stride;
+        const double alpha = k.alpha[i], weight = k.weight[i];
+        for (int64_t l = 0; l < count; ++l) {
+            row[l] = alpha * prev[l] + weight * row[l];
+        }
+    }
+    for (int i = n - 2; i > 0; --i) {
+        double* __restrict row = first + i * stride;
+        const double* __restrict next = row + stride;
+        const double alpha = k.alpha[i];
+        for (int64_t l = 0; l < count; ++l) {
+            row[l] += alpha * next[l];
+        }
+    }
+}
+
+// Явная часть шага для count соседних линий в той же раскладке: во внутренних узлах
+// f[i] += r * (f[i-1] - 2 f[i] + f[i+1]) по значениям до прохода. Исходные значения
+// предыдущего узла хранятся в previous (count элементов), крайние узлы не меняются
+inline void explicitBlock(double* first, int64_t count, int n, ptrdiff_t stride, double r, double* previous) {
+    double* __restrict saved = previous;
+    for (int64_t l = 0; l < count; ++l) {
+        saved[l] = first[l];
+    }
+    for (int i = 1; i < n - 1; ++i) {
+        double* __restrict row = first + i * stride;
+        const double* __restrict next = row + stride;
+        for (int64_t l = 0; l < count; ++l) {
+            double current = row[l];
+            row[l] = current + r * (saved[l] - 2.0 * current + next[l]);
+            saved[l] = current;
+        }
+    }
+}
+
+// Неявный шаг для пластины из N узлов с температурами Tl и Tr на краях. При заданном dt
+// матрица постоянна: ее разложение хранится для двух последних dt (постоянный шаг или
+// шаги BDF2 при смене шага и после нее), и шаг по времени - это только прямая и обратная
+// подстановка без делений
+class HeatEngine1D {
+private:
+    int N = 0;
+    double offDiagonal = 0.0;      // lambda / h^2
+    double heatCapacity = 0.0;     // rho * c
+    double Tl = 0.0, Tr = 0.0;
+    SweepCoefficients factors[2];
+    double factorStep[2] = {0.0, 0.0};
+    int lastUsed = 0;
+
+public:
+    HeatEngine1D() = default;
+    HeatEngine1D(int nodes, double h, double lambda, double rho, double c, double leftTemp, double rightTemp)
+        : N(nodes), offDiagonal(lambda / (h * h)), heatCapacity(rho * c), Tl(leftTemp), Tr(rightTemp) {}
+
+    // Разложение матрицы для шага dt (строится при первом обращении)
+    const SweepCoefficients& factorization(double dt) {
+        for (int slot = 0; slot < 2; ++slot) {
+            if (factorStep[slot] == dt) {
+                lastUsed = slot;
+                return factors[slot];
+            }
+        }
+        lastUsed = 1 - lastUsed;
+        factors[lastUsed] = SweepCoefficients(N, offDiagonal, heatCapacity / dt);
+        factorStep[lastUsed] = dt;
+        return factors[lastUsed];
+    }
+
+    // Один неявный шаг dt: поле from -> поле to (from и to могут совпадать)
+    void step(const double* from, double dt, double* to) {
+        const SweepCoefficients& k = factorization(dt);
+        const double* __restrict alpha = k.alpha.data();
+        const double* __restrict weight = k.weight.data();
+        to[0] = Tl;
+        to[N - 1] = Tr;
+        // Прямая подстановка: beta записывается в to
+        for (int i = 1; i < N - 1; ++i) {
+            to[i] = alpha[i] * to[i - 1] + weight[i] * from[i];
+        }
+        // Обратная подстановка
+        for (int i = N - 2; i > 0; --i) {
+            to[i] += alpha[i] * to[i + 1];
+        }
+    }
+
+    int nodes() const { return N; }
+};
+
+// Статистика расчета по времени
+struct AdaptiveStats {
+    long accepted = 0;       // Принятые шаги
+    long rejected = 0;       // Отклоненные шаги
+    long sweeps = 0;         // Число прогонок
+    double finalTime = 0.0;  // Момент окончания расчета
+    double minStep = 0.0;    // Наименьший и наибольший принятый шаг
+    double maxStep = 0.0;
+    bool steady = false;     // Остановка по выходу на стационарный режим
+};
+
+// Расчет с постоянным шагом tau до t_end. step(from, dt, to) - один неявный шаг
+// (например, HeatEngine1D::step); from и to могут совпадать
+template<typename Step>
+AdaptiveStats integrateFixed(std::vector<double>& T, double tau, double t_end, Step&& step) {
+    AdaptiveStats stats;
+    double time = 0.0;
+    while (time < t_end) {
+        time += tau;
+        step(T.data(), tau, T.data());
+        ++stats.accepted;
+        ++stats.sweeps;
+    }
+    stats.finalTime = time;
+    stats.minStep = stats.maxStep = tau;
+    return stats;
+}
+
+// Расчет с адаптивным шагом по времени, начиная с шага tau, по схеме BDF2 с переменным
+// шагом (второй порядок, устойчива при любом шаге и гасит жесткие моды). Шаг BDF2 -
+// один неявный шаг step с комбинацией двух предыдущих полей в правой части:
+//   T' = step(((1 + w)^2 T - w^2 T_prev) / (1 + 2w), dt (1 + w) / (1 + 2w)),  w = dt / dt_prev,
+// поэтому на шаг нужна одна прогонка. Ошибка принятого решения оценивается сравнением
+// с квадратичной экстраполяцией по трем предыдущим полям (оба приближения второго порядка,
+// их разность пропорциональна главному члену ошибки BDF2) и не превышает tolerance
+// (градусы) во внутренних узлах; крайние узлы задает step. Первый шаг - неявная схема
+// Эйлера с оценкой удвоением (три прогонки).
+// Расчет останавливается раньше t_end, если при текущей скорости изменения поле до t_end
+// изменится меньше чем на tolerance. Температуры в моменты outputTimes (по возрастанию)
+// интерполируются в snapshots
+template<typename Step>
+AdaptiveStats integrateAdaptive(std::vector<double>& T, double tau, double t_end, double tolerance,
+                                const std::vector<double>& outputTimes, std::vector<std::vector<double>>& snapshots,
+                                Step&& step) {
+    AdaptiveStats stats;
+    const size_t N = T.size();
+    std::vector<double> next(N), previous(N), older(N); // T(time + dt), T(time - h1), T(time - h1 - h2)
+    double previousStep = 0.0, olderStep = 0.0;         // h1, h2; 0 - предыдущих шагов еще нет
+    snapshots.assign(outputTimes.size(), std::vector<double>());
+    size_t nextOutput = 0;
+    double time = 0.0;
+    double dt = tau;
+    const double minStep = t_end * 1e-12;
+
+    while (time < t_end) {
+        dt = std::min(dt, t_end - time);
+        const bool startup = previousStep == 0.0;
+        double error = 0.0;
+        if (startup) {
+            // Шаг dt против двух шагов dt/2; принимается решение из двух полушагов,
+            // его ошибка - примерно половина разности
+            step(T.data(), dt, older.data());
+            step(T.data(), 0.5 * dt, previous.data());
+            step(previous.data(), 0.5 * dt, next.data());
+            stats.sweeps += 3;
+            for (size_t i = 1; i + 1 < N; ++i) {
+                error = std::max(error, 0.5 * std::fabs(next[i] - older[i]));
+            }
+        } else {
+            const double ratio = dt / previousStep;
+            const double current = (1.0 + ratio) * (1.0 + ratio) / (1.0 + 2.0 * ratio);
+            const double past = ratio * ratio / (1.0 + 2.0 * ratio);
+            const double implicitDt = dt * (1.0 + ratio) / (1.0 + 2.0 * ratio);
+            for (size_t i = 0; i < N; ++i) {
+                next[i] = current * T[i] - past * previous[i];
+            }
+            step(next.data(), implicitDt, next.data());
+            ++stats.sweeps;
+
+            // Экстраполяция по моментам time - h1 - h2, time - h1, time на time + dt
+            const double span = dt + previousStep, reach = span + olderStep;
+            const double wOlder = span * dt / (olderStep * (previousStep + olderStep));
+            const double wPrevious = -reach * dt / (olderStep * previousStep);
+            const double wCurrent = reach * span / (previousStep * (previousStep + olderStep));
+            // Главные члены ошибок с общим множителем dt (dt + h1) / 6 при третьей
+            // производной: у BDF2 implicitDt, у экстраполяции dt + h1 + h2
+            const double share = implicitDt / (implicitDt + reach);
+            for (size_t i = 1; i + 1 < N; ++i) {
+                double predicted = wOlder * older[i] + wPrevious * previous[i] + wCurrent * T[i];
+                error = std::max(error, share * std::fabs(next[i] - predicted));
+            }
+        }
+        const double order = startup ? 2.0 : 3.0; // Ошибка шага ~ dt^order
+        if (error > tolerance && dt > minStep) {
+            dt *= std::max(0.2, 0.9 * std::pow(tolerance / error, 1.0 / order));
+            ++stats.rejected;
+            continue;
+        }
+
+        double rate = 0.0; // Наибольшая скорость изменения температуры на шаге
+        for (size_t i = 0; i < N; ++i) {
+            rate = std::max(rate, std::fabs(next[i] - T[i]) / dt);
+        }
+        // Моменты вывода внутри шага: линейная интерполяция между T(time) и T(time + dt)
+        while (nextOutput < outputTimes.size() && outputTimes[nextOutput] <= time + dt) {
+            double w = std::max(0.0, (outputTimes[nextOutput] - time) / dt);
+            snapshots[nextOutput].resize(N);
+            for (size_t i = 0; i < N; ++i) {
+                snapshots[nextOutput][i] = (1.0 - w) * T[i] + w * next[i];
+            }
+            ++nextOutput;
+        }
+        // Сдвиг истории: older <- previous <- T <- next
+        if (startup) {
+            older.swap(T);
+            previousStep = olderStep = 0.5 * dt;
+        } else {
+            older.swap(previous);
+            previous.swap(T);
+            olderStep = previousStep;
+            previousStep = dt;
+        }
+        T.swap(next);
+        time += dt;
+        ++stats.accepted;
+        stats.minStep = stats.accepted == 1 ? dt : std::min(stats.minStep, dt);
+        stats.maxStep = std::max(stats.maxStep, dt);
+
+        if (time < t_end && rate * (t_end - time) < tolerance) {
+            stats.steady = true;
+            break;
+        }
+        // Следующий шаг не больше двух предыдущих (при w > 1 + sqrt(2) BDF2 теряет
+        // устойчивость). Небольшое увеличение шага не стоит нового разложения матрицы:
+        // при неизменном dt шаг берет готовое разложение из кэша
+        dt = previousStep;
+        double growth = error > 0.0 ? std::min(2.0, 0.9 * std::pow(tolerance / error, 1.0 / order)) : 2.0;
+        if (growth < 1.0 || growth > 1.2) {
+            dt *= growth;
+        }
+    }
+    stats.finalTime = time;
+    // После выхода на стационарный режим поле дальше не меняется
+    for (; nextOutput < outputTimes.size(); ++nextOutput) {
+        snapshots[nextOutput] = T;
+    }
+    return stats;
+}
@@ -2,10 +2,163 @@
 #include <vector>
 #include <fstream>
 #include <string>
+#include <cmath>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <cstdint>
+#include <limits>
+#include "heat_engine.h"
 #include <windows.h> // Подключение библиотеки для работы с Windows API (нужно для установки кодировки UTF-8 в PowerShel или CMD)
 
 using namespace std;
 
+// Выполнение body(part) для part = 0..parts-1 в отдельных потоках (part 0 - в вызывающем)
+void runParallel(int parts, const function<void(int)>& body) {
+    vector<thread> pool;
+    for (int part = 1; part < parts; ++part) {
+        pool.emplace_back(body, part);
+    }
+    body(0);
+    for (thread& t : pool) {
+        t.join();
+    }
+}
+
+// Прогонка вдоль одной линии сетки из n узлов (соседние узлы через stride элементов)
+// с закрепленными крайними значениями line[0] и line[n-1]:
+// -a T[i-1] + (2a + m) T[i] - a T[i+1] = m * T_old[i], где T_old берется из line,
+// а решение записывается на его место. alpha и beta - рабочие массивы на n элементов
+void sweepLine(double* line, int n, ptrdiff_t stride, double a, double m, double* alpha, double* beta) {
+    const double b = 2.0 * a + m;
+    alpha[0] = 0.0;
+    beta[0] = line[0];
+    for (int i = 1; i < n - 1; ++i) {
+        double denominator = b - a * alpha[i - 1];
+        alpha[i] = a / denominator;
+        beta[i] = (a * beta[i - 1] + m * line[i * stride]) / denominator;
+    }
+    for (int i = n - 2; i >= 1; --i) {
+        line[i * stride] = alpha[i] * line[(i + 1) * stride] + beta[i];
+    }
+}
+
+// Параллельное решение трехдиагональной системы с постоянными коэффициентами
+// -a T[i-1] + b T[i] - a T[i+1] = d[i], i = 1..N-2, при заданных T[0] и T[N-1]
+// методом разбиения (вариант SPIKE). Внутренние узлы делятся разделителями на P частей.
+// В каждой части решение записывается как T = y + T_left * u + T_right * v, где y -
+// прогонка с нулевыми краями, u и v - отклики на единичное значение левого и правого
+// разделителя. Значения на разделителях находятся из малой трехдиагональной системы
+// размера P-1, затем части восстанавливаются независимо. u, v и прогоночные
+// коэффициенты не зависят от правой части и вычисляются один раз (setup), поэтому
+// шаг по времени - это две параллельные прогонки по частям и одна короткая посередине
+class ParallelTridiagonal {
+private:
+    int N = 0, P = 0;
+    double a = 0, b = 0;
+    vector<int> separators;              // separators[0] = 0, separators[P] = N - 1
+    vector<double> alpha, inverse, u, v; // По узлам
+    vector<double> lower, upper, reducedAlpha, reducedInverse, reducedRhs; // Система для разделителей
+
+public:
+    bool matches(int nodes, double offDiagonal, double diagonal, int parts) const {
+        return N == nodes && a == offDiagonal && b == diagonal && P == parts;
+    }
+
+    void setup(int nodes, double offDiagonal, double diagonal, int parts) {
+        N = nodes;
+        a = offDiagonal;
+        b = diagonal;
+        P = parts;
+        separators.resize(P + 1);
+        for (int k = 0; k <= P; ++k) {
+            separators[k] = int(int64_t(N - 1) * k / P);
+        }
+        alpha.resize(N);
+        inverse.resize(N);
+        u.resize(N);
+        v.resize(N);
+        runParallel(P, [&](int k) {
+            int first = separators[k] + 1, last = separators[k + 1] - 1;
+            double alphaPrev = 0.0, uBeta = 1.0;
+            for (int i = first; i <= last; ++i) {
+                inverse[i] = 1.0 / (b - a * alphaPrev);
+                alpha[i] = a * inverse[i];
+                alphaPrev = alpha[i];
+                uBeta = a * uBeta * inverse[i];
+                u[i] = uBeta;
+            }
+            double uNext = 0.0, vNext = 1.0;
+            for (int i = last; i >= first; --i) {
+                u[i] += alpha[i] * uNext;
+                v[i] = alpha[i] * vNext;
+                uNext = u[i];
+                vNext = v[i];
+            }
+        });
+        // Уравнение в разделителе p: -a T[p-1] + b T[p] - a T[p+1] = d[p], где T[p-1] и
+        // T[p+1] выражены через соседние разделители
+        lower.assign(P, 0.0);
+        upper.assign(P, 0.0);
+        reducedAlpha.assign(P, 0.0);
+        reducedInverse.assign(P, 0.0);
+        reducedRhs.assign(P, 0.0);
+        for (int k = 1; k < P; ++k) {
+            int p = separators[k];
+            lower[k] = -a * u[p - 1];
+            upper[k] = -a * v[p + 1];
+            double diagonalK = b - a * v[p - 1] - a * u[p + 1];
+            reducedInverse[k] = 1.0 / (diagonalK - lower[k] * reducedAlpha[k - 1]);
+            reducedAlpha[k] = upper[k] * reducedInverse[k];
+        }
+    }
+
+    // На входе T[1..N-2] - значения, из которых правая часть d[i] = scale * T[i];
+    // T[0] и T[N-1] - граничные значения. На выходе T - решение
+    void solve(double* T, double scale) {
+        // Прогонка с нулевыми краями в каждой части: T[i] = y[i]
+        runParallel(P, [&](int k) {
+            int first = separators[k] + 1, last = separators[k + 1] - 1;
+            double beta = 0.0;
+            for (int i = first; i <= last; ++i) {
+                beta = (a * beta + scale * T[i]) * inverse[i];
+                T[i] = beta;
+            }
+            double next = 0.0;
+            for (int i = last; i >= first; --i) {
+                T[i] += alpha[i] * next;
+                next = T[i];
+            }
+        });
+        // Значения на разделителях
+        for (int k = 1; k < P; ++k) {
+            int p = separators[k];
+            double rhs = scale * T[p] + a * T[p - 1] + a * T[p + 1];
+            if (k == 1) {
+                rhs -= lower[k] * T[0];
+            }
+            if (k == P - 1) {
+                rhs -= upper[k] * T[N - 1];
+            }
+            reducedRhs[k] = (rhs - lower[k] * reducedRhs[k - 1]) * reducedInverse[k];
+        }
+        for (int k = P - 1; k >= 1; --k) {
+            double next = k + 1 < P ? T[separators[k + 1]] : 0.0;
+            T[separators[k]] = reducedRhs[k] - reducedAlpha[k] * next;
+        }
+        // Восстановление частей по значениям разделителей
+        runParallel(P, [&](int k) {
+            int first = separators[k] + 1, last = separators[k + 1] - 1;
+            double left = T[separators[k]], right = T[separators[k + 1]];
+            for (int i = first; i <= last; ++i) {
+                T[i] += left * u[i] + right * v[i];
+            }
+        });
+    }
+};
+
 // Класс для решения одномерного уравнения теплопроводности методом прогонки
 class HeatConduction1D {
 private:
@@ -21,9 +174,60 @@ private:
     double h;                // Шаг по пространственной координате
     double tau;              // Шаг по времени
     vector<double> T;   // Вектор для хранения температур
-    vector<double> alpha, beta;  // Прогоночные коэффициенты
+    HeatEngine1D engine;     // Неявный шаг с разложенной матрицей
+    vector<double> outputTimes;            // Моменты времени для вывода (solveAdaptive)
+    vector<vector<double>> snapshots;      // Температуры в моменты outputTimes
+    AdaptiveStats stats;      // Шаги, прогонки, момент окончания расчета
+    unsigned threads = 0;     // Потоков для прогонки (0 - все ядра при N >= PARALLEL_MIN_NODES)
+    // Параллельная прогонка для двух последних dt, как в HeatEngine1D: при адаптивном
+    // шаге (BDF2) пока шаг не меняется, настройка не строится заново
+    ParallelTridiagonal parallelSweeps[2];
+    int lastSweep = 0;
+
+    // Настройка параллельной прогонки для матрицы шага (строится при первом обращении)
+    ParallelTridiagonal& parallelSweep(double offDiagonal, double diagonal, int parts) {
+        for (int slot = 0; slot < 2; ++slot) {
+            if (parallelSweeps[slot].matches(N, offDiagonal, diagonal, parts)) {
+                lastSweep = slot;
+                return parallelSweeps[slot];
+            }
+        }
+        lastSweep = 1 - lastSweep;
+        parallelSweeps[lastSweep].setup(N, offDiagonal, diagonal, parts);
+        return parallelSweeps[lastSweep];
+    }
+
+    // Число частей для параллельной прогонки; 1 - последовательная прогонка
+    int sweepParts() const {
+        if (threads == 0 && N < PARALLEL_MIN_NODES) {
+            return 1;
+        }
+        unsigned parts = threads != 0 ? threads : max(1u, thread::hardware_concurrency());
+        return int(min<int64_t>(parts, max(1, (N - 2) / 2)));
+    }
+
+    // Один неявный шаг dt: поле from -> поле to (from и to могут совпадать)
+    void implicitStep(const double* from, double dt, double* to) {
+        int parts = sweepParts();
+        if (parts > 1) {
+            double offDiagonal = lambda / (h * h);
+            double massOverTau = rho * c / dt;
+            double diagonal = 2.0 * offDiagonal + massOverTau;
+            // Устанавливаем граничные условия
+            if (to != from) {
+                copy(from, from + N, to);
+            }
+            to[0] = Tl;
+            to[N - 1] = Tr;
+            parallelSweep(offDiagonal, diagonal, parts).solve(to, massOverTau);
+        } else {
+            engine.step(from, dt, to);
+        }
+    }
 
 public:
+    static const int PARALLEL_MIN_NODES = 1 << 20; // С этого числа узлов прогонка параллельная
+
     // Конструктор инициализации параметров задачи
     HeatConduction1D(int nodes, double length, double conductivity, double density, double heatCapacity,
                      double initialTemp, double leftTemp, double rightTemp, double endTime)
@@ -33,38 +237,40 @@ public:
         h = L / (N - 1);            // Расчет шага по пространству
         tau = t_end / 100.0;        // Задаем шаг по времени
         T.resize(N, T0);            // Инициализируем вектор температур начальными значениями
-        alpha.resize(N, 0.0);       // Вектор коэффициентов alpha для метода прогонки
-        beta.resize(N, 0.0);        // Вектор коэффициентов beta для метода прогонки
+        engine = HeatEngine1D(N, h, lambda, rho, c, Tl, Tr);
     }
 
-    // Метод для выполнения численного решения уравнения теплопроводности
+    // Метод для выполнения численного решения уравнения теплопроводности с постоянным шагом
     void solve() {
-        double time = 0.0;
-        while (time < t_end) {
-            time += tau;
-            
-            // Устанавливаем граничные условия
-            alpha[0] = 0.0;
-            beta[0] = Tl;
+        stats = integrateFixed(T, tau, t_end, [this](const double* from, double dt, double* to) {
+            implicitStep(from, dt, to);
+        });
+    }
 
-            // Вычисляем прогоночные коэффициенты alpha и beta для внутренней области
-            for (int i = 1; i < N - 1; ++i) {
-                double ai = lambda / (h * h);
-                double bi = 2.0 * lambda / (h * h) + rho * c / tau;
-                double ci = lambda / (h * h);
-                double fi = -rho * c * T[i] / tau;
+    // Решение с адаптивным шагом по времени (integrateAdaptive из heat_engine.h): шаг
+    // подбирается так, чтобы его погрешность не превышала tolerance (в градусах), расчет
+    // останавливается раньше t_end при выходе на стационарный режим. Температуры в моменты
+    // times интерполируются между соседними шагами
+    void solveAdaptive(double tolerance, const vector<double>& times = vector<double>()) {
+        outputTimes = times;
+        sort(outputTimes.begin(), outputTimes.end());
+        stats = integrateAdaptive(T, tau, t_end, tolerance, outputTimes, snapshots,
+                                  [this](const double* from, double dt, double* to) {
+            implicitStep(from, dt, to);
+        });
+    }
 
-                alpha[i] = ai / (bi - ci * alpha[i - 1]);
-                beta[i] = (ci * beta[i - 1] - fi) / (bi - ci * alpha[i - 1]);
-            }
+    double temperature(int node) const { return T[node]; }
 
-            // Применяем правое граничное условие
-            T[N - 1] = Tr;
+    // Потоки для прогонки: 0 - автоматически (параллельно для больших N), 1 - последовательно
+    void setThreads(unsigned count) { threads = count; }
 
-            // Обратная прогонка для определения температуры
-            for (int i = N - 2; i >= 0; --i) {
-                T[i] = alpha[i] * T[i + 1] + beta[i];
-            }
+    // Вывод статистики расчета
+    void printStatistics() const {
+        cout << "Шагов по времени: " << stats.accepted << " (отклонено: " << stats.rejected
+             << "), прогонок: " << stats.sweeps << endl;
+        if (stats.steady) {
+            cout << "Стационарный режим достигнут при t = " << stats.finalTime << " с, расчет остановлен" << endl;
         }
     }
 
@@ -95,11 +301,800 @@ public:
             cerr << "Ошибка открытия файла для записи!" << endl;
         }
     }
+
+    // Запись температур в моменты вывода: столбец x и по столбцу на каждый момент
+    void saveSnapshotsToTXTFile(const string& filename) const {
+        ofstream file(filename);
+        if (file.is_open()) {
+            file << "x";
+            for (double t : outputTimes) {
+                file << ",T(" << t << ")";
+            }
+            file << "\n";
+            for (int i = 0; i < N; ++i) {
+                file << i * h;
+                for (const vector<double>& snapshot : snapshots) {
+                    file << "," << snapshot[i];
+                }
+                file << "\n";
+            }
+            file.close();
+            cout << "Результаты сохранены в файл " << filename << endl;
+        } else {
+            cerr << "Ошибка открытия файла для записи!" << endl;
+        }
+    }
+};
+
+// Параметры одного стержня (пластины) для пакетного расчета
+struct RodParameters {
+    double L;       // Толщина
+    double lambda;  // Коэффициент теплопроводности
+    double rho;     // Плотность
+    double c;       // Удельная теплоемкость
+    double T0;      // Начальная температура
+    double Tl;      // Температура на левом краю
+    double Tr;      // Температура на правом краю
+};
+
+// Пакетный расчет K независимых стержней с одинаковым числом узлов N и временем t_end.
+// Данные хранятся по узлам (SoA): T[i * K + r] - температура узла i стержня r, поэтому
+// на каждом шаге прогонки коэффициенты соседних стержней лежат подряд и внутренний
+// цикл по стержням компилятор выполняет векторными инструкциями (AVX: 4-8 стержней
+// за инструкцию при сборке с -O3 -march=native). Прогоночные коэффициенты блока
+// считаются один раз, шаг по времени - только подстановки. Блоки по BLOCK стержней
+// распределяются между потоками, каждый поток ведет свой блок через все шаги по времени
+class HeatConductionBatch {
+private:
+    int N;                   // Количество узлов (одинаково для всех стержней)
+    int K;                   // Количество стержней
+    double t_end;            // Время, до которого нужно считать
+    double tau;              // Шаг по времени (как в HeatConduction1D: t_end / 100)
+    vector<double> a;        // lambda / h^2 для каждого стержня
+    vector<double> b;        // 2 * lambda / h^2
+    vector<double> m;        // rho * c
+    vector<double> Tl, Tr;   // Граничные температуры
+    vector<double> T;        // Температуры в раскладке SoA
+
+    // Расчет стержней [r0, r0 + w) всеми шагами по времени. Матрица шага от времени не
+    // зависит, поэтому прогоночные коэффициенты считаются один раз до цикла по времени,
+    // как в SweepCoefficients: beta[i] = alpha[i] * beta[i-1] + weight[i] * T[i]. alpha и
+    // weight - рабочие массивы потока размером N * BLOCK в той же раскладке с шагом w;
+    // beta записывается на место T
+    void solveBlock(int r0, int w, vector<double>& alphaBuffer, vector<double>& weightBuffer) {
+        double* __restrict alpha = alphaBuffer.data();
+        double* __restrict weight = weightBuffer.data();
+        for (int j = 0; j < w; ++j) {
+            alpha[j] = 0.0;
+        }
+        for (int i = 1; i < N - 1; ++i) {
+            const double* __restrict alphaPrev = alpha + size_t(i - 1) * w;
+            double* __restrict alphaCur = alpha + size_t(i) * w;
+            double* __restrict weightCur = weight + size_t(i) * w;
+            for (int j = 0; j < w; ++j) {
+                double ai = a[r0 + j];
+                double massOverTau = m[r0 + j] / tau;
+                double inverse = 1.0 / (b[r0 + j] + massOverTau - ai * alphaPrev[j]);
+                alphaCur[j] = ai * inverse;
+                weightCur[j] = massOverTau * inverse;
+            }
+        }
+        double* __restrict first = T.data() + r0;
+        double* __restrict last = T.data() + size_t(N - 1) * K + r0;
+        double time = 0.0;
+        while (time < t_end) {
+            time += tau;
+            for (int j = 0; j < w; ++j) {
+                first[j] = Tl[r0 + j];
+                last[j] = Tr[r0 + j];
+            }
+            // Прямая подстановка: один узел для всех w стержней блока
+            for (int i = 1; i < N - 1; ++i) {
+                double* __restrict Ti = T.data() + size_t(i) * K + r0;
+                const double* __restrict Tprev = Ti - K;
+                const double* __restrict alphaCur = alpha + size_t(i) * w;
+                const double* __restrict weightCur = weight + size_t(i) * w;
+                for (int j = 0; j < w; ++j) {
+                    Ti[j] = alphaCur[j] * Tprev[j] + weightCur[j] * Ti[j];
+                }
+            }
+            // Обратная подстановка
+            for (int i = N - 2; i > 0; --i) {
+                double* __restrict Ti = T.data() + size_t(i) * K + r0;
+                const double* __restrict Tnext = Ti + K;
+                const double* __restrict alphaCur = alpha + size_t(i) * w;
+                for (int j = 0; j < w; ++j) {
+                    Ti[j] += alphaCur[j] * Tnext[j];
+                }
+            }
+        }
+    }
+
+public:
+    static constexpr int BLOCK = 64; // Стержней в блоке одного потока
+
+    HeatConductionBatch(int nodes, double endTime, const vector<RodParameters>& rods)
+        : N(nodes), K(int(rods.size())), t_end(endTime), tau(endTime / 100.0),
+          a(K), b(K), m(K), Tl(K), Tr(K), T(size_t(nodes) * rods.size()) {
+        for (int r = 0; r < K; ++r) {
+            double h = rods[r].L / (N - 1);
+            a[r] = rods[r].lambda / (h * h);
+            b[r] = 2.0 * rods[r].lambda / (h * h);
+            m[r] = rods[r].rho * rods[r].c;
+            Tl[r] = rods[r].Tl;
+            Tr[r] = rods[r].Tr;
+            for (int i = 0; i < N; ++i) {
+                T[size_t(i) * K + r] = rods[r].T0;
+            }
+        }
+    }
+
+    // Расчет всех стержней в threads потоках (0 - по числу ядер)
+    void solve(unsigned threads = 0) {
+        if (threads == 0) {
+            threads = max(1u, thread::hardware_concurrency());
+        }
+        int blocks = (K + BLOCK - 1) / BLOCK;
+        threads = min(threads, unsigned(max(blocks, 1)));
+        atomic<int> nextBlock(0);
+        auto worker = [&]() {
+            vector<double> alphaBuffer(size_t(N) * BLOCK), weightBuffer(size_t(N) * BLOCK);
+            for (int block = nextBlock++; block < blocks; block = nextBlock++) {
+                int r0 = block * BLOCK;
+                solveBlock(r0, min(BLOCK, K - r0), alphaBuffer, weightBuffer);
+            }
+        };
+        vector<thread> pool;
+        for (unsigned t = 1; t < threads; ++t) {
+            pool.emplace_back(worker);
+        }
+        worker();
+        for (thread& t : pool) {
+            t.join();
+        }
+    }
+
+    double temperature(int rod, int node) const { return T[size_t(node) * K + rod]; }
+    int rods() const { return K; }
+};
+
+// Число потоков для многомерных расчетов (0 - по числу ядер)
+int threadParts(unsigned threads) {
+    return int(threads != 0 ? threads : max(1u, thread::hardware_concurrency()));
+}
+
+// Выполнение tasks независимых задач, поровну разделенных между parts потоками
+void parallelTasks(int64_t tasks, int parts, const function<void(int64_t)>& task) {
+    runParallel(parts, [&](int part) {
+        for (int64_t t = tasks * part / parts; t < tasks * (part + 1) / parts; ++t) {
+            task(t);
+        }
+    });
+}
+
+constexpr int64_t SWEEP_BLOCK = 64; // Линий в блоке: блок n x 64 остается в кэше L2 между проходами
+
+// Прогонка по слоям layerBegin..layerEnd-1: слой начинается с data + layer * layerStride,
+// его линии лежат подряд (width штук, крайние - граница области и не меняются),
+// узлы линии идут с шагом stride. Задачи - блоки по SWEEP_BLOCK линий
+void sweepLayers(double* data, int64_t layerBegin, int64_t layerEnd, ptrdiff_t layerStride, int64_t width, int n,
+                 ptrdiff_t stride, const SweepCoefficients& k, int parts) {
+    const int64_t blocks = (width - 2 + SWEEP_BLOCK - 1) / SWEEP_BLOCK;
+    parallelTasks((layerEnd - layerBegin) * blocks, parts, [&](int64_t task) {
+        int64_t l0 = 1 + (task % blocks) * SWEEP_BLOCK;
+        sweepBlock(data + (layerBegin + task / blocks) * layerStride + l0, min(SWEEP_BLOCK, width - 1 - l0), n,
+                   stride, k);
+    });
+}
+
+// Прогонка по одной линии за раз (для сравнения): line(l) возвращает начало линии
+// или nullptr для линий на границе области
+void sweepEachLine(int64_t lines, int n, ptrdiff_t stride, const SweepCoefficients& k, int parts,
+                   const function<double*(int64_t)>& line) {
+    runParallel(parts, [&](int part) {
+        vector<double> alpha(n), beta(n);
+        for (int64_t l = lines * part / parts; l < lines * (part + 1) / parts; ++l) {
+            double* start = line(l);
+            if (start != nullptr) {
+                sweepLine(start, n, stride, k.a, k.m, alpha.data(), beta.data());
+            }
+        }
+    });
+}
+
+// Явная часть шага в той же раскладке, что и sweepLayers: f += r * (вторая разность вдоль
+// направления с шагом stride) во внутренних узлах линий слоев layerBegin..layerEnd-1
+void explicitLayers(double* data, int64_t layerBegin, int64_t layerEnd, ptrdiff_t layerStride, int64_t width, int n,
+                    ptrdiff_t stride, double r, int parts) {
+    const int64_t blocks = (width - 2 + SWEEP_BLOCK - 1) / SWEEP_BLOCK;
+    parallelTasks((layerEnd - layerBegin) * blocks, parts, [&](int64_t task) {
+        double previous[SWEEP_BLOCK];
+        int64_t l0 = 1 + (task % blocks) * SWEEP_BLOCK;
+        explicitBlock(data + (layerBegin + task / blocks) * layerStride + l0, min(SWEEP_BLOCK, width - 1 - l0), n,
+                      stride, r, previous);
+    });
+}
+
+// Явная часть шага по одной линии за раз (для сравнения), линии задаются как в sweepEachLine
+void explicitEachLine(int64_t lines, int n, ptrdiff_t stride, double r, int parts,
+                      const function<double*(int64_t)>& line) {
+    parallelTasks(lines, parts, [&](int64_t l) {
+        double previous;
+        double* start = line(l);
+        if (start != nullptr) {
+            explicitBlock(start, 1, n, stride, r, &previous);
+        }
+    });
+}
+
+// Блочное транспонирование count матриц rows x cols, лежащих подряд в src, в dst (cols x rows);
+// при accumulate транспонированная матрица прибавляется к dst. Плитки TILE x TILE
+// помещаются в кэш L1, поэтому и чтение, и запись идут целыми строками кэша
+void transposePlanes(const double* src, double* dst, int64_t rows, int64_t cols, int64_t count, int parts,
+                     bool accumulate = false) {
+    const int64_t TILE = 32;
+    const int64_t tileRows = (rows + TILE - 1) / TILE;
+    parallelTasks(count * tileRows, parts, [&](int64_t task) {
+        const double* s = src + (task / tileRows) * rows * cols;
+        double* d = dst + (task / tileRows) * rows * cols;
+        int64_t i0 = (task % tileRows) * TILE, i1 = min(rows, i0 + TILE);
+        for (int64_t j0 = 0; j0 < cols; j0 += TILE) {
+            int64_t j1 = min(cols, j0 + TILE);
+            // Запись идет подряд, чтение - с шагом cols: при шаге записи, кратном степени
+            // двойки (плоскости 256 x 256), строки плитки dst попадали в одни наборы кэша
+            for (int64_t j = j0; j < j1; ++j) {
+                if (accumulate) {
+                    for (int64_t i = i0; i < i1; ++i) {
+                        d[j * rows + i] += s[i * cols + j];
+                    }
+                } else {
+                    for (int64_t i = i0; i < i1; ++i) {
+                        d[j * rows + i] = s[i * cols + j];
+                    }
+                }
+            }
+        }
+    });
+}
+
+// Транспонирование матрицы rows x cols с явной частью шага вдоль ее строк: во внутренних
+// элементах dst[j][i] = s[i][j] + r * (s[i-1][j] - 2 s[i][j] + s[i+1][j]), граница копируется.
+// Явный проход не требует отдельного чтения поля: соседние строки плитки уже в кэше
+void transposeExplicit(const double* src, double* dst, int64_t rows, int64_t cols, double r, int parts) {
+    const int64_t TILE = 32;
+    const int64_t tileRows = (rows + TILE - 1) / TILE;
+    parallelTasks(tileRows, parts, [&](int64_t task) {
+        int64_t i0 = task * TILE, i1 = min(rows, i0 + TILE);
+        const int64_t first = max<int64_t>(i0, 1), last = min(i1, rows - 1); // Внутренние строки плитки
+        for (int64_t j0 = 0; j0 < cols; j0 += TILE) {
+            int64_t j1 = min(cols, j0 + TILE);
+            for (int64_t j = j0; j < j1; ++j) {
+                const double* column = src + j;
+                double* out = dst + j * rows;
+                if (j == 0 || j == cols - 1) {
+                    for (int64_t i = i0; i < i1; ++i) {
+                        out[i] = column[i * cols];
+                    }
+                    continue;
+                }
+                if (i0 == 0) {
+                    out[0] = column[0];
+                }
+                for (int64_t i = first; i < last; ++i) {
+                    const double* value = column + i * cols;
+                    out[i] = *value + r * (value[-cols] - 2.0 * *value + value[cols]);
+                }
+                if (i1 == rows) {
+                    out[rows - 1] = column[(rows - 1) * cols];
+                }
+            }
+        }
+    });
+}
+
+// Двумерная задача теплопроводности в прямоугольнике Lx x Ly: на грани x = 0 температура Tl,
+// на грани x = Lx - Tr, на гранях y = 0 и y = Ly - Tside. Схема переменных направлений
+// Писмена - Рэкфорда (второй порядок по времени): шаг tau - два полушага tau/2,
+//   (1 - tau/2 Ax) T* = (1 + tau/2 Ay) T,   (1 - tau/2 Ay) T' = (1 + tau/2 Ax) T*,
+// где Ax, Ay - вторые разности по x и y. Поле хранится по строкам T[y * Nx + x]. Прогонка и
+// явная часть идут блоками соседних линий, поэтому их направление должно быть внешним
+// индексом: для y это так и есть, а для x поле транспонируется в буфер и обратно (явная
+// часть полушагов считается при транспонировании)
+class HeatConduction2D {
+private:
+    int Nx, Ny;              // Количество узлов по x и y
+    double lambda, rho, c;   // Теплопроводность, плотность, теплоемкость
+    double t_end;            // Время, до которого нужно считать
+    double hx, hy;           // Шаги по пространству
+    double tau;              // Шаг по времени
+    SweepCoefficients kx, ky; // Прогоночные коэффициенты направлений для полушага tau/2
+    double rx, ry;           // Множители явной части полушага: (lambda / h^2) / (2 rho c / tau)
+    vector<double> T;        // Температуры T[y * Nx + x]
+    vector<double> buffer;   // Транспонированное поле T[x * Ny + y]
+    unsigned threads = 0;    // Потоков (0 - все ядра)
+    bool transpose = true;   // false - прогонка по одной линии, по y с шагом Nx (для сравнения)
+
+public:
+    HeatConduction2D(int nodesX, int nodesY, double lengthX, double lengthY, double conductivity, double density,
+                     double heatCapacity, double initialTemp, double leftTemp, double rightTemp, double sideTemp,
+                     double endTime)
+        : Nx(nodesX), Ny(nodesY), lambda(conductivity), rho(density), c(heatCapacity), t_end(endTime),
+          hx(lengthX / (nodesX - 1)), hy(lengthY / (nodesY - 1)), tau(endTime / 100.0),
+          kx(nodesX, conductivity / (hx * hx), 2.0 * density * heatCapacity / tau),
+          ky(nodesY, conductivity / (hy * hy), 2.0 * density * heatCapacity / tau),
+          rx(kx.a / kx.m), ry(ky.a / ky.m),
+          T(size_t(nodesX) * nodesY, initialTemp), buffer(T.size()) {
+        for (int y = 0; y < Ny; ++y) {
+            for (int x = 0; x < Nx; ++x) {
+                double& value = T[size_t(y) * Nx + x];
+                if (x == 0) value = leftTemp;
+                else if (x == Nx - 1) value = rightTemp;
+                else if (y == 0 || y == Ny - 1) value = sideTemp;
+            }
+        }
+    }
+
+    void setThreads(unsigned count) { threads = count; }
+    void setTranspose(bool enabled) { transpose = enabled; }
+
+    // Один шаг по времени
+    void step() {
+        const int parts = threadParts(threads);
+        if (!transpose) {
+            auto rows = [&](int64_t y) { return y == 0 || y == Ny - 1 ? nullptr : T.data() + y * Nx; };
+            auto columns = [&](int64_t x) { return x == 0 || x == Nx - 1 ? nullptr : T.data() + x; };
+            explicitEachLine(Nx, Ny, Nx, ry, parts, columns);
+            sweepEachLine(Ny, Nx, 1, kx, parts, rows);
+            explicitEachLine(Ny, Nx, 1, rx, parts, rows);
+            sweepEachLine(Nx, Ny, Nx, ky, parts, columns);
+            return;
+        }
+        // Первый полушаг: явно по y вместе с транспонированием [y][x] -> [x][y], неявно по x
+        transposeExplicit(T.data(), buffer.data(), Ny, Nx, ry, parts);
+        sweepLayers(buffer.data(), 0, 1, 0, Ny, Nx, Ny, kx, parts);
+        // Второй полушаг: явно по x вместе с транспонированием обратно, неявно по y
+        transposeExplicit(buffer.data(), T.data(), Nx, Ny, rx, parts);
+        sweepLayers(T.data(), 0, 1, 0, Nx, Ny, Nx, ky, parts);
+    }
+
+    // Расчет до t_end (100 шагов, как в HeatConduction1D)
+    void solve() {
+        double time = 0.0;
+        while (time < t_end) {
+            time += tau;
+            step();
+        }
+    }
+
+    double temperature(int x, int y) const { return T[size_t(y) * Nx + x]; }
+
+    void saveResultsToTXTFile(const string& filename) const {
+        ofstream file(filename);
+        if (file.is_open()) {
+            file << "x,y,temperature\n";  // Заголовок
+            for (int y = 0; y < Ny; ++y) {
+                for (int x = 0; x < Nx; ++x) {
+                    file << x * hx << "," << y * hy << "," << temperature(x, y) << "\n";
+                }
+            }
+            file.close();
+            cout << "Результаты сохранены в файл " << filename << endl;
+        } else {
+            cerr << "Ошибка открытия файла для записи!" << endl;
+        }
+    }
+};
+
+// Трехмерная задача в параллелепипеде: грань x = 0 - Tl, x = Lx - Tr, остальные грани - Tside.
+// Схема Дугласа в приращениях (второй порядок по времени, устойчива и в 3D, в отличие от
+// схемы Писмена - Рэкфорда): при A = Ax + Ay + Az
+//   (1 - tau/2 Ax) D1 = tau A T,  (1 - tau/2 Ay) D2 = D1,  (1 - tau/2 Az) D3 = D2,  T' = T + D3,
+// приращения D на границе нулевые. Поле хранится как T[(z * Ny + y) * Nx + x]. Правая часть
+// записывается в буфер с транспонированными плоскостями [z][x][y], где внешние индексы - x
+// и z, и прогонки по x и z идут там блоками линий, соседних по y. Прогонка по y выполняется
+// сразу для T': (1 - tau/2 Ay) T' = T + D2 - tau/2 Ay T, поэтому D2 прибавляется к полю
+// вместе с обратным транспонированием
+class HeatConduction3D {
+private:
+    int Nx, Ny, Nz;          // Количество узлов по x, y, z
+    double lambda, rho, c;   // Теплопроводность, плотность, теплоемкость
+    double t_end;            // Время, до которого нужно считать
+    double hx, hy, hz;       // Шаги по пространству
+    double tau;              // Шаг по времени
+    SweepCoefficients kx, ky, kz; // Прогоночные коэффициенты направлений для tau/2
+    double rx, ry, rz;       // (lambda / h^2) / (2 rho c / tau) по направлениям
+    vector<double> T;        // Температуры
+    vector<double> buffer;   // Приращения D (с транспонированными плоскостями)
+    unsigned threads = 0;    // Потоков (0 - все ядра)
+    bool transpose = true;   // false - прогонка по одной линии, по y и z с шагом Nx и Nx * Ny
+
+    static bool edge(int64_t i, int n) { return i == 0 || i == n - 1; }
+
+    // Правая часть первой прогонки tau A T в масштабе прогонки: 2 (rx dx^2 + ry dy^2 + rz dz^2) T
+    // во внутренних узлах, 0 на границе. При transposed запись в out[(z * Nx + x) * Ny + y],
+    // иначе в раскладке поля. Задача - ROWS строк y одной плоскости: они считаются в рабочий
+    // массив, а в транспонированную плоскость записываются отрезками по ROWS подряд
+    void residual(double* out, bool transposed, int parts) const {
+        const int64_t ROWS = 32;
+        const int64_t plane = int64_t(Nx) * Ny;
+        const int64_t rowBlocks = (Ny + ROWS - 1) / ROWS;
+        const double cx = 2.0 * rx, cy = 2.0 * ry, cz = 2.0 * rz;
+        parallelTasks(Nz * rowBlocks, parts, [&](int64_t task) {
+            const int64_t z = task / rowBlocks, y0 = (task % rowBlocks) * ROWS, y1 = min<int64_t>(Ny, y0 + ROWS);
+            double* d = out + z * plane;
+            vector<double> local(transposed ? size_t(ROWS) * Nx : 0);
+            for (int64_t y = y0; y < y1; ++y) {
+                double* __restrict line = transposed ? local.data() + (y - y0) * Nx : d + y * Nx;
+                if (edge(z, Nz) || edge(y, Ny)) {
+                    fill(line, line + Nx, 0.0);
+                    continue;
+                }
+                const double* __restrict t = T.data() + z * plane + y * Nx;
+                line[0] = line[Nx - 1] = 0.0;
+                for (int x = 1; x < Nx - 1; ++x) {
+                    line[x] = cx * (t[x - 1] - 2.0 * t[x] + t[x + 1]) + cy * (t[x - Nx] - 2.0 * t[x] + t[x + Nx]) +
+                              cz * (t[x - plane] - 2.0 * t[x] + t[x + plane]);
+                }
+            }
+            if (transposed) {
+                for (int x = 0; x < Nx; ++x) {
+                    for (int64_t y = y0; y < y1; ++y) {
+                        d[x * Ny + y] = local[(y - y0) * Nx + x];
+                    }
+                }
+            }
+        });
+    }
+
+public:
+    HeatConduction3D(int nodesX, int nodesY, int nodesZ, double lengthX, double lengthY, double lengthZ,
+                     double conductivity, double density, double heatCapacity, double initialTemp,
+                     double leftTemp, double rightTemp, double sideTemp, double endTime)
+        : Nx(nodesX), Ny(nodesY), Nz(nodesZ), lambda(conductivity), rho(density), c(heatCapacity), t_end(endTime),
+          hx(lengthX / (nodesX - 1)), hy(lengthY / (nodesY - 1)), hz(lengthZ / (nodesZ - 1)), tau(endTime / 100.0),
+          kx(nodesX, conductivity / (hx * hx), 2.0 * density * heatCapacity / tau),
+          ky(nodesY, conductivity / (hy * hy), 2.0 * density * heatCapacity / tau),
+          kz(nodesZ, conductivity / (hz * hz), 2.0 * density * heatCapacity / tau),
+          rx(kx.a / kx.m), ry(ky.a / ky.m), rz(kz.a / kz.m),
+          T(size_t(nodesX) * nodesY * nodesZ, initialTemp), buffer(T.size()) {
+        for (int z = 0; z < Nz; ++z) {
+            for (int y = 0; y < Ny; ++y) {
+                for (int x = 0; x < Nx; ++x) {
+                    double& value = T[(size_t(z) * Ny + y) * Nx + x];
+                    if (x == 0) value = leftTemp;
+                    else if (x == Nx - 1) value = rightTemp;
+                    else if (edge(y, Ny) || edge(z, Nz)) value = sideTemp;
+                }
+            }
+        }
+    }
+
+    void setThreads(unsigned count) { threads = count; }
+    void setTranspose(bool enabled) { transpose = enabled; }
+
+    // Один шаг по времени
+    void step() {
+        const int parts = threadParts(threads);
+        const int64_t plane = int64_t(Nx) * Ny;
+        double* d = buffer.data();
+        if (!transpose) {
+            residual(d, false, parts);
+            sweepEachLine(int64_t(Nz) * Ny, Nx, 1, kx, parts, [&](int64_t l) {
+                return edge(l / Ny, Nz) || edge(l % Ny, Ny) ? nullptr : d + l * Nx;
+            });
+            sweepEachLine(int64_t(Nz) * Nx, Ny, Nx, ky, parts, [&](int64_t l) {
+                return edge(l / Nx, Nz) || edge(l % Nx, Nx) ? nullptr : d + (l / Nx) * plane + l % Nx;
+            });
+            sweepEachLine(plane, Nz, plane, kz, parts, [&](int64_t l) {
+                return edge(l / Nx, Ny) || edge(l % Nx, Nx) ? nullptr : d + l;
+            });
+            parallelTasks(Nz, parts, [&](int64_t z) {
+                for (int64_t i = z * plane; i < (z + 1) * plane; ++i) {
+                    T[i] += d[i];
+                }
+            });
+            return;
+        }
+        // Приращения в плоскостях [x][y]: прогонка по x (слои - внутренние z), затем по z
+        // (слои - внутренние x, шаг по узлам - плоскость)
+        residual(d, true, parts);
+        sweepLayers(d, 1, Nz - 1, plane, Ny, Nx, Ny, kx, parts);
+        sweepLayers(d, 1, Nx - 1, Ny, Ny, Nz, plane, kz, parts);
+        // Правая часть для T': T - tau/2 Ay T + D2, затем неявно по y (линии по x подряд)
+        explicitLayers(T.data(), 1, Nz - 1, plane, Nx, Ny, Nx, -ry, parts);
+        transposePlanes(d, T.data(), Nx, Ny, Nz, parts, true);
+        sweepLayers(T.data(), 1, Nz - 1, plane, Nx, Ny, Nx, ky, parts);
+    }
+
+    // Расчет до t_end (100 шагов, как в HeatConduction1D)
+    void solve() {
+        double time = 0.0;
+        while (time < t_end) {
+            time += tau;
+            step();
+        }
+    }
+
+    double temperature(int x, int y, int z) const { return T[(size_t(z) * Ny + y) * Nx + x]; }
+
+    void saveResultsToTXTFile(const string& filename) const {
+        ofstream file(filename);
+        if (file.is_open()) {
+            file << "x,y,z,temperature\n";  // Заголовок
+            for (int z = 0; z < Nz; ++z) {
+                for (int y = 0; y < Ny; ++y) {
+                    for (int x = 0; x < Nx; ++x) {
+                        file << x * hx << "," << y * hy << "," << z * hz << "," << temperature(x, y, z) << "\n";
+                    }
+                }
+            }
+            file.close();
+            cout << "Результаты сохранены в файл " << filename << endl;
+        } else {
+            cerr << "Ошибка открытия файла для записи!" << endl;
+        }
+    }
 };
 
+// Бенчмарк пакетного расчета: K стержней из разных материалов по N узлов.
+// Сравниваются последовательный расчет HeatConduction1D для каждого стержня,
+// пакетный расчет в одном потоке и во всех потоках
+void runBatchBenchmark(int K, int N, double t_end) {
+    vector<RodParameters> rods(K);
+    unsigned seed = 1;
+    auto random = [&seed]() {
+        seed = seed * 1103515245u + 12345u;
+        return double((seed >> 8) & 0xFFFF) / 65535.0;
+    };
+    for (RodParameters& rod : rods) {
+        rod.L = 0.05 + 0.1 * random();
+        rod.lambda = 1.0 + 400.0 * random();   // От керамики до меди
+        rod.rho = 2000.0 + 7000.0 * random();
+        rod.c = 380.0 + 600.0 * random();
+        rod.T0 = 20.0;
+        rod.Tl = 100.0 + 200.0 * random();
+        rod.Tr = 20.0 + 80.0 * random();
+    }
+
+    auto t0 = chrono::high_resolution_clock::now();
+    vector<double> reference(size_t(K) * N);
+    for (int r = 0; r < K; ++r) {
+        HeatConduction1D rod(N, rods[r].L, rods[r].lambda, rods[r].rho, rods[r].c, rods[r].T0, rods[r].Tl, rods[r].Tr, t_end);
+        rod.solve();
+        for (int i = 0; i < N; ++i) {
+            reference[size_t(r) * N + i] = rod.temperature(i);
+        }
+    }
+    auto t1 = chrono::high_resolution_clock::now();
+    HeatConductionBatch single(N, t_end, rods);
+    single.solve(1);
+    auto t2 = chrono::high_resolution_clock::now();
+    HeatConductionBatch parallel(N, t_end, rods);
+    parallel.solve();
+    auto t3 = chrono::high_resolution_clock::now();
+
+    double maxError = 0.0;
+    for (int r = 0; r < K; ++r) {
+        for (int i = 0; i < N; ++i) {
+            maxError = max(maxError, fabs(parallel.temperature(r, i) - reference[size_t(r) * N + i]));
+            maxError = max(maxError, fabs(single.temperature(r, i) - reference[size_t(r) * N + i]));
+        }
+    }
+    double secSequential = chrono::duration<double>(t1 - t0).count();
+    double secSingle = chrono::duration<double>(t2 - t1).count();
+    double secParallel = chrono::duration<double>(t3 - t2).count();
+    cout << "Стержней: " << K << ", узлов: " << N << ", шагов по времени: 100, потоков: "
+         << max(1u, thread::hardware_concurrency()) << endl;
+    cout << "Последовательно (HeatConduction1D): " << secSequential << " с, " << K / secSequential << " систем/с" << endl;
+    cout << "Пакет, 1 поток: " << secSingle << " с, " << K / secSingle << " систем/с, ускорение "
+         << secSequential / secSingle << "x" << endl;
+    cout << "Пакет, все потоки: " << secParallel << " с, " << K / secParallel << " систем/с, ускорение "
+         << secSequential / secParallel << "x" << endl;
+    cout << "Трехдиагональных систем в секунду (пакет, все потоки): " << 100.0 * K / secParallel << endl;
+    cout << "Максимальная разница с последовательным расчетом: " << maxError << endl;
+}
+
+// Бенчмарк параллельной прогонки на одной сетке из N узлов: последовательная прогонка
+// против метода разбиения на threads частей (100 шагов по времени, как в solve)
+void runTridiagonalBenchmark(int N, unsigned threads, double t_end) {
+    HeatConduction1D sequential(N, 0.1, 46.0, 7800.0, 460.0, 20.0, 300.0, 100.0, t_end);
+    sequential.setThreads(1);
+    HeatConduction1D parallel(N, 0.1, 46.0, 7800.0, 460.0, 20.0, 300.0, 100.0, t_end);
+    parallel.setThreads(threads);
+
+    auto t0 = chrono::high_resolution_clock::now();
+    sequential.solve();
+    auto t1 = chrono::high_resolution_clock::now();
+    parallel.solve();
+    auto t2 = chrono::high_resolution_clock::now();
+
+    double maxError = 0.0, maxValue = 0.0;
+    for (int i = 0; i < N; ++i) {
+        maxError = max(maxError, fabs(parallel.temperature(i) - sequential.temperature(i)));
+        maxValue = max(maxValue, fabs(sequential.temperature(i)));
+    }
+    double secSequential = chrono::duration<double>(t1 - t0).count();
+    double secParallel = chrono::duration<double>(t2 - t1).count();
+    cout << "Узлов: " << N << ", шагов по времени: 100, частей: " << threads << endl;
+    cout << "Последовательная прогонка: " << secSequential * 10.0 << " мс на шаг" << endl;
+    cout << "Метод разбиения: " << secParallel * 10.0 << " мс на шаг, ускорение " << secSequential / secParallel << "x" << endl;
+    // Число обусловленности матрицы шага (4a + rho c / tau) / (rho c / tau): разница двух
+    // точных в арифметике методов ограничена величиной порядка cond * eps
+    double h = 0.1 / (N - 1);
+    double massOverTau = 7800.0 * 460.0 / (t_end / 100.0);
+    double condition = (4.0 * 46.0 / (h * h) + massOverTau) / massOverTau;
+    cout << "Максимальная разница: " << maxError << " (относительная " << maxError / maxValue
+         << ", уровень округления cond * eps = " << condition * numeric_limits<double>::epsilon() << ")" << endl;
+}
+
+// Бенчмарк одного неявного шага для пластины из N узлов: прогонка с пересчетом
+// коэффициентов и делениями на каждом шаге против подстановок с разложением матрицы,
+// построенным один раз (HeatEngine1D)
+void runStepBenchmark(int N, int steps) {
+    const double h = 0.1 / (N - 1), dt = 0.6;
+    const double offDiagonal = 46.0 / (h * h), massOverTau = 7800.0 * 460.0 / dt;
+    vector<double> recomputed(N, 20.0), factored(N, 20.0), alpha(N), beta(N);
+    recomputed[0] = factored[0] = 300.0;
+    recomputed[N - 1] = factored[N - 1] = 100.0;
+    HeatEngine1D engine(N, h, 46.0, 7800.0, 460.0, 300.0, 100.0);
+
+    auto t0 = chrono::high_resolution_clock::now();
+    for (int s = 0; s < steps; ++s) {
+        sweepLine(recomputed.data(), N, 1, offDiagonal, massOverTau, alpha.data(), beta.data());
+    }
+    auto t1 = chrono::high_resolution_clock::now();
+    engine.factorization(dt);
+    auto t2 = chrono::high_resolution_clock::now();
+    for (int s = 0; s < steps; ++s) {
+        engine.step(factored.data(), dt, factored.data());
+    }
+    auto t3 = chrono::high_resolution_clock::now();
+
+    double maxError = 0.0, maxValue = 0.0;
+    for (int i = 0; i < N; ++i) {
+        maxError = max(maxError, fabs(recomputed[i] - factored[i]));
+        maxValue = max(maxValue, fabs(recomputed[i]));
+    }
+    double secRecomputed = chrono::duration<double>(t1 - t0).count() / steps;
+    double secFactored = chrono::duration<double>(t3 - t2).count() / steps;
+    cout << "Узлов: " << N << ", шагов по времени: " << steps << endl;
+    cout << "Прогонка с пересчетом коэффициентов: " << secRecomputed * 1e3 << " мс на шаг" << endl;
+    cout << "Разложение матрицы (один раз): " << chrono::duration<double>(t2 - t1).count() * 1e3 << " мс" << endl;
+    cout << "Подстановки: " << secFactored * 1e3 << " мс на шаг, ускорение " << secRecomputed / secFactored
+         << "x, разница " << maxError << " (относительная " << maxError / maxValue << ")" << endl;
+}
+
+// Стационарная температура в прямоугольнике Lx x Ly (граничные условия HeatConduction2D):
+// ряд Фурье по sin(k pi y / Ly), нечетные k. Отношения sinh считаются через экспоненты,
+// чтобы члены с большими k не переполнялись
+double steadyTemperature2D(double x, double y, double Lx, double Ly, double Tl, double Tr, double Tside) {
+    auto sinhRatio = [](double p, double q) { // sinh(p) / sinh(q), 0 <= p <= q
+        return exp(p - q) * (1.0 - exp(-2.0 * p)) / (1.0 - exp(-2.0 * q));
+    };
+    const double pi = acos(-1.0);
+    double sum = 0.0;
+    for (int k = 1; k < 2000; k += 2) {
+        double w = k * pi / Ly;
+        sum += 4.0 / (k * pi) * sin(w * y) *
+               ((Tl - Tside) * sinhRatio(w * (Lx - x), w * Lx) + (Tr - Tside) * sinhRatio(w * x, w * Lx));
+    }
+    return Tside + sum;
+}
+
+// Проверка двумерной схемы по точному решению: расчет до выхода на стационарный режим
+// сравнивается с рядом Фурье в центральной части пластины 0.1 x 0.05 м (углы с разрывом
+// граничных условий исключены). Погрешность разностной схемы - O(h^2), поэтому при
+// удвоении числа узлов она должна уменьшаться примерно в 4 раза
+void runAdiSteadyCheck() {
+    const double Lx = 0.1, Ly = 0.05, Tl = 300.0, Tr = 100.0, Tside = 20.0;
+    double previous = 0.0;
+    for (int n : {21, 41, 81}) {
+        int nx = n, ny = (n - 1) / 2 + 1;
+        // Шаг 2 с, 1000 шагов: медленная мода затухает как exp(-0.06 t), а у схемы
+        // Писмена - Рэкфорда быстрые моды при большом шаге гаснут медленно
+        HeatConduction2D plate(nx, ny, Lx, Ly, 46.0, 7800.0, 460.0, 20.0, Tl, Tr, Tside, 200.0);
+        for (int s = 0; s < 1000; ++s) {
+            plate.step();
+        }
+        double error = 0.0;
+        for (int y = (ny - 1) / 4; y <= 3 * (ny - 1) / 4; ++y) {
+            for (int x = (nx - 1) / 4; x <= 3 * (nx - 1) / 4; ++x) {
+                double exact = steadyTemperature2D(x * Lx / (nx - 1), y * Ly / (ny - 1), Lx, Ly, Tl, Tr, Tside);
+                error = max(error, fabs(plate.temperature(x, y) - exact));
+            }
+        }
+        cout << "Стационарный режим 2D " << nx << "x" << ny << ": отклонение от точного решения " << error;
+        if (previous > 0.0) {
+            cout << " (уменьшилось в " << previous / error << " раз)";
+        }
+        cout << endl;
+        previous = error;
+    }
+}
+
+// Бенчмарк схемы переменных направлений: сетки n2 x n2 и n3 x n3 x n3 (стальная пластина
+// 0.1 м), прогонка блоками соседних линий с транспонированием против прогонки по одной линии.
+// Перед замерами - проверка двумерной схемы по точному стационарному решению
+void runAdiBenchmark(int n2, int n3, int steps) {
+    runAdiSteadyCheck();
+    cout << "Схема переменных направлений, потоков: " << threadParts(0) << ", шагов: " << steps << endl;
+    auto timeSteps = [steps](auto& problem) {
+        problem.step(); // Прогрев: первое касание страниц памяти
+        auto t0 = chrono::high_resolution_clock::now();
+        for (int s = 0; s < steps; ++s) {
+            problem.step();
+        }
+        return chrono::duration<double>(chrono::high_resolution_clock::now() - t0).count() / steps;
+    };
+
+    HeatConduction2D plain2(n2, n2, 0.1, 0.1, 46.0, 7800.0, 460.0, 20.0, 300.0, 100.0, 20.0, 60.0);
+    HeatConduction2D fast2(n2, n2, 0.1, 0.1, 46.0, 7800.0, 460.0, 20.0, 300.0, 100.0, 20.0, 60.0);
+    plain2.setTranspose(false);
+    double secPlain2 = timeSteps(plain2), secFast2 = timeSteps(fast2);
+    double diff2 = 0.0;
+    for (int y = 0; y < n2; ++y) {
+        for (int x = 0; x < n2; ++x) {
+            diff2 = max(diff2, fabs(plain2.temperature(x, y) - fast2.temperature(x, y)));
+        }
+    }
+    double nodes2 = double(n2) * n2 * 2;
+    cout << "2D " << n2 << "x" << n2 << ": по одной линии " << secPlain2 * 1e3 << " мс/шаг, блоками с транспонированием "
+         << secFast2 * 1e3 << " мс/шаг (" << nodes2 / secFast2 * 1e-6 << " млн узлов-прогонок/с), ускорение "
+         << secPlain2 / secFast2 << "x, разница " << diff2 << endl;
+
+    HeatConduction3D plain3(n3, n3, n3, 0.1, 0.1, 0.1, 46.0, 7800.0, 460.0, 20.0, 300.0, 100.0, 20.0, 60.0);
+    plain3.setTranspose(false);
+    double secPlain3 = timeSteps(plain3);
+    HeatConduction3D fast3(n3, n3, n3, 0.1, 0.1, 0.1, 46.0, 7800.0, 460.0, 20.0, 300.0, 100.0, 20.0, 60.0);
+    double secFast3 = timeSteps(fast3);
+    double diff3 = 0.0;
+    for (int z = 0; z < n3; ++z) {
+        for (int y = 0; y < n3; ++y) {
+            for (int x = 0; x < n3; ++x) {
+                diff3 = max(diff3, fabs(plain3.temperature(x, y, z) - fast3.temperature(x, y, z)));
+            }
+        }
+    }
+    double nodes3 = double(n3) * n3 * n3 * 3;
+    cout << "3D " << n3 << "x" << n3 << "x" << n3 << ": по одной линии " << secPlain3 * 1e3 << " мс/шаг, блоками с транспонированием "
+         << secFast3 * 1e3 << " мс/шаг (" << nodes3 / secFast3 * 1e-6 << " млн узлов-прогонок/с), ускорение "
+         << secPlain3 / secFast3 << "x, разница " << diff3 << endl;
+}
+
 // Основная функция
-int main() {
+int main(int argc, char* argv[]) {
     SetConsoleOutputCP(CP_UTF8);
+    if (argc > 1 && string(argv[1]) == "--bench_batch") {
+        // --bench_batch [стержней узлов t_end], по умолчанию 10000 стержней по 200 узлов, t_end = 60 с
+        int K = argc > 2 ? stoi(argv[2]) : 10000;
+        int N = argc > 3 ? stoi(argv[3]) : 200;
+        double t_end = argc > 4 ? stod(argv[4]) : 60.0;
+        runBatchBenchmark(K, N, t_end);
+        return 0;
+    }
+    if (argc > 1 && string(argv[1]) == "--bench_adi") {
+        // --bench_adi [n2 n3 шагов], по умолчанию сетки 1024x1024 и 256x256x256, 5 шагов
+        int n2 = argc > 2 ? stoi(argv[2]) : 1024;
+        int n3 = argc > 3 ? stoi(argv[3]) : 256;
+        int steps = argc > 4 ? stoi(argv[4]) : 5;
+        runAdiBenchmark(n2, n3, steps);
+        return 0;
+    }
+    if (argc > 1 && string(argv[1]) == "--bench_step") {
+        // --bench_step [узлов шагов], по умолчанию 10^6 узлов, 100 шагов
+        int N = argc > 2 ? stoi(argv[2]) : 1000000;
+        int steps = argc > 3 ? stoi(argv[3]) : 100;
+        runStepBenchmark(N, steps);
+        return 0;
+    }
+    if (argc > 1 && string(argv[1]) == "--bench_tridiagonal") {
+        // --bench_tridiagonal [узлов потоков t_end], по умолчанию 10^7 узлов, все ядра, t_end = 60 с
+        int N = argc > 2 ? stoi(argv[2]) : 10000000;
+        unsigned threads = argc > 3 ? unsigned(stoul(argv[3])) : max(1u, thread::hardware_concurrency());
+        double t_end = argc > 4 ? stod(argv[4]) : 60.0;
+        runTridiagonalBenchmark(N, threads, t_end);
+        return 0;
+    }
     int N;
     double L, lambda, rho, c, T0, Tl, Tr, t_end;
 
@@ -121,10 +1116,33 @@ int main() {
     cin >> Tl;
     cout << "Введите температуру на правом краю, Tr (С): ";
     cin >> Tr;
+    if (N < 3) {
+        cout << "Число узлов должно быть не меньше 3" << endl;
+        return 1;
+    }
+    double tolerance;
+    cout << "Введите допустимую погрешность шага по времени, С (0 - постоянный шаг t_end/100): ";
+    cin >> tolerance;
+    vector<double> times;
+    if (tolerance > 0) {
+        int count;
+        cout << "Введите число моментов времени для вывода (0 - только t_end): ";
+        cin >> count;
+        times.resize(max(count, 0));
+        for (double& t : times) {
+            cout << "Введите момент времени, t (с): ";
+            cin >> t;
+        }
+    }
 
     // Создаем объект и выполняем расчет
     HeatConduction1D heatConduction(N, L, lambda, rho, c, T0, Tl, Tr, t_end);
-    heatConduction.solve();
+    if (tolerance > 0) {
+        heatConduction.solveAdaptive(tolerance, times);
+    } else {
+        heatConduction.solve();
+    }
+    heatConduction.printStatistics();
 
     // Сохраняем результаты в текстовый файл
     heatConduction.saveResultsToTextFile("oop_temp.txt");
@@ -132,5 +1150,10 @@ int main() {
     // Сохраняем результаты в txt
     heatConduction.saveResultsToTXTFile("oop_res.txt");
 
+    // Температуры в заданные моменты времени
+    if (!times.empty()) {
+        heatConduction.saveSnapshotsToTXTFile("oop_snapshots.txt");
+    }
+
     return 0;
 }
\ No newline at end of file
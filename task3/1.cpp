@@ -7,340 +7,4465 @@
 #include <string> //Для использования getline
 #include <sstream> // Подключаем библиотеку для работы с потоками строк (istringstream и ostringstream)
 #include <vector> // Для работы с векторами
+#include <thread> // Для фонового потока логгера
+#include <atomic> // Для lock-free кольцевого буфера логгера
+#include <cstdint> // Для intptr_t
+#include <cstdio> // Для remove (удаление временного файла бенчмарка)
+#include <charconv> // Для from_chars (быстрый разбор чисел без учета локали)
+#include <cstring> // Для memchr
+#include <algorithm> // Для min
+#include <memory> // Для shared_ptr (матрица, отображенная из файла)
+#include <limits> // Для numeric_limits (точность текстового вывода при конвертации)
+#include <new> // Для выровненного operator new
+#include <mutex> // Для пула буферов матриц
+#include <map> // Для списков свободных буферов пула
+#include <type_traits> // Для is_trivially_copyable
+#include <functional> // Для function (распределение задач по потокам)
+#include <cmath> // Для fabs
+#include <future> // Для shared_future (ожидание операнда, который загружает другое задание)
+#include <condition_variable> // Для постоянного пула потоков и ожидания фонового потока логгера
+#include <exception> // Для exception_ptr (исключение задачи пула передается вызывающему)
+#ifdef TASK3_WITH_ZLIB
+#include <zlib.h> // Сжатый вывод .gz (сборка с -DTASK3_WITH_ZLIB и -lz)
+#endif
+#ifdef _WIN32
+#include <windows.h> // Для отображения файла в память (CreateFileMapping)
+#else
+#include <sys/mman.h> // Для отображения файла в память (mmap)
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h> // Интринсики AVX2 / AVX-512 для умножения матриц
+#define TASK3_X86_SIMD 1
+#endif
 
 // Подключаем пространство имен std 
 using namespace std; 
 
-//Класс для сохранения веременных данных при работе с матрицами
+// Файл, отображенный в память. При copyOnWrite страницы доступны на запись,
+// но изменения остаются в памяти процесса и в файл не попадают
+class MappedFile {
+private:
+    const char* ptr = nullptr;
+    size_t length = 0;
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = NULL;
+#else
+    int fd = -1;
+#endif
+
+public:
+    explicit MappedFile(const string& path, bool copyOnWrite = false) {
+#ifdef _WIN32
+        // FILE_SHARE_DELETE: отображенный файл можно заменить другим (replaceFile)
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING,
+                           FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+        if (file == INVALID_HANDLE_VALUE) {
+            return;
+        }
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+            return;
+        }
+        length = size_t(fileSize.QuadPart);
+        mapping = CreateFileMappingA(file, NULL, copyOnWrite ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, NULL);
+        if (mapping != NULL) {
+            ptr = static_cast<const char*>(MapViewOfFile(mapping, copyOnWrite ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0));
+        }
+#else
+        fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0) {
+            return;
+        }
+        length = size_t(st.st_size);
+        void* p = mmap(nullptr, length, copyOnWrite ? PROT_READ | PROT_WRITE : PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED) {
+            ptr = static_cast<const char*>(p);
+            madvise(p, length, MADV_SEQUENTIAL);
+        }
+#endif
+        if (ptr == nullptr) {
+            length = 0;
+        }
+    }
+
+    ~MappedFile() {
+#ifdef _WIN32
+        if (ptr != nullptr) UnmapViewOfFile(ptr);
+        if (mapping != NULL) CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+#else
+        if (ptr != nullptr) munmap(const_cast<char*>(ptr), length);
+        if (fd >= 0) close(fd);
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Файл открыт (пустой файл тоже считается открытым)
+    bool isOpen() const {
+#ifdef _WIN32
+        return file != INVALID_HANDLE_VALUE;
+#else
+        return fd >= 0;
+#endif
+    }
+    const char* begin() const { return ptr; }
+    const char* end() const { return ptr + length; }
+    size_t size() const { return length; }
+};
+
+// Выравнивание буферов матриц: строка кэша и ширина регистра AVX-512
+const size_t MATRIX_ALIGNMENT = 64;
+
+// Аллокатор для векторов: выравнивание MATRIX_ALIGNMENT и отсутствие обнуления при resize.
+// Страницы нового буфера не трогаются до первой записи, поэтому их размещает по узлам NUMA
+// параллельное ядро, которое пишет результат (first touch), а не поток, выделивший память
+template<typename T>
+struct AlignedAllocator {
+    typedef T value_type;
+
+    AlignedAllocator() = default;
+    template<typename U>
+    AlignedAllocator(const AlignedAllocator<U>&) {}
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(::operator new(n * sizeof(T), align_val_t(MATRIX_ALIGNMENT)));
+    }
+    void deallocate(T* p, size_t) {
+        ::operator delete(p, align_val_t(MATRIX_ALIGNMENT));
+    }
+
+    // Конструирование без аргументов - инициализация по умолчанию (для double - без записи)
+    template<typename U>
+    void construct(U* p) { ::new (static_cast<void*>(p)) U; }
+    template<typename U, typename... Args>
+    void construct(U* p, Args&&... args) { ::new (static_cast<void*>(p)) U(forward<Args>(args)...); }
+
+    template<typename U>
+    bool operator==(const AlignedAllocator<U>&) const { return true; }
+    template<typename U>
+    bool operator!=(const AlignedAllocator<U>&) const { return false; }
+};
+
+// Пул буферов матриц. Освобожденный буфер не возвращается в malloc, а кладется
+// в список свободных буферов того же размера, и следующая матрица такой же
+// формы забирает его без выделения памяти. Объем удерживаемых буферов ограничен
+class MatrixPool {
+private:
+    mutex lock;
+    map<size_t, vector<void*>> freeLists; // Размер в байтах -> свободные буферы
+    size_t cachedBytes = 0;
+    size_t maxCachedBytes;
+
+public:
+    explicit MatrixPool(size_t maxCachedBytes = size_t(1) << 30) : maxCachedBytes(maxCachedBytes) {}
+
+    ~MatrixPool() {
+        for (auto& entry : freeLists) {
+            for (void* p : entry.second) {
+                ::operator delete(p, align_val_t(MATRIX_ALIGNMENT));
+            }
+        }
+    }
+
+    MatrixPool(const MatrixPool&) = delete;
+    MatrixPool& operator=(const MatrixPool&) = delete;
+
+    void* acquire(size_t bytes) {
+        {
+            lock_guard<mutex> guard(lock);
+            auto it = freeLists.find(bytes);
+            if (it != freeLists.end() && !it->second.empty()) {
+                void* p = it->second.back();
+                it->second.pop_back();
+                cachedBytes -= bytes;
+                return p;
+            }
+        }
+        return ::operator new(bytes, align_val_t(MATRIX_ALIGNMENT));
+    }
+
+    void release(void* p, size_t bytes) {
+        {
+            lock_guard<mutex> guard(lock);
+            if (cachedBytes + bytes <= maxCachedBytes) {
+                freeLists[bytes].push_back(p);
+                cachedBytes += bytes;
+                return;
+            }
+        }
+        ::operator delete(p, align_val_t(MATRIX_ALIGNMENT));
+    }
+
+    // Пул, из которого берут память матрицы, создаваемые в текущем потоке (nullptr - обычное выделение)
+    static MatrixPool*& current() {
+        thread_local MatrixPool* pool = nullptr;
+        return pool;
+    }
+};
+
+// Пока объект жив, новые матрицы текущего потока берут буферы из pool.
+// Пул должен пережить все матрицы, созданные в его области
+class MatrixPoolScope {
+private:
+    MatrixPool* previous;
+
+public:
+    explicit MatrixPoolScope(MatrixPool& pool) : previous(MatrixPool::current()) { MatrixPool::current() = &pool; }
+    ~MatrixPoolScope() { MatrixPool::current() = previous; }
+    MatrixPoolScope(const MatrixPoolScope&) = delete;
+    MatrixPoolScope& operator=(const MatrixPoolScope&) = delete;
+};
+
+//Класс для сохранения веременных данных при работе с матрицами.
+//Данные выровнены на MATRIX_ALIGNMENT байт. Матрица копируется глубоко и дешево перемещается;
+//буфер берется из пула MatrixPool::current(), если он задан, и возвращается в тот же пул
 template<typename T = double>
 class MatrixDense {
+    static_assert(is_trivially_copyable<T>::value, "MatrixDense хранит только тривиально копируемые элементы");
+
     T* __data; // Указатель на массив данных типа T
+    shared_ptr<MappedFile> __mapping; // Если задан, данные лежат в отображенном файле и не освобождаются
+    MatrixPool* __pool = nullptr; // Пул, из которого взят буфер
     unsigned _m, _n; // Размеры матрицы: количество строк (_m) и столбцов (_n)
     //unsigned — это модификатор типа, который указывает, что переменные будут хранить только неотрицательные целые числа
 
+    size_t bytes() const { return size_t(_m) * _n * sizeof(T); }
+
+    void allocate() {
+        __pool = MatrixPool::current();
+        if (bytes() == 0) {
+            __data = nullptr;
+        } else if (__pool != nullptr) {
+            __data = static_cast<T*>(__pool->acquire(bytes()));
+        } else {
+            __data = static_cast<T*>(::operator new(bytes(), align_val_t(MATRIX_ALIGNMENT)));
+        }
+    }
+
+    void release() {
+        if (__data != nullptr && !__mapping) {
+            if (__pool != nullptr) {
+                __pool->release(__data, bytes());
+            } else {
+                ::operator delete(__data, align_val_t(MATRIX_ALIGNMENT));
+            }
+        }
+        __data = nullptr;
+        __mapping.reset();
+        __pool = nullptr;
+    }
+
 public:
     // Конструктор, принимающий размеры матрицы
     MatrixDense(unsigned m, unsigned n) : _m(m), _n(n) {
-        // Выделение памяти для хранения элементов матрицы
-        __data = new T[_m * _n]; // Создаем одномерный массив для хранения элементов матрицы
+        // Выделение выровненной памяти для хранения элементов матрицы
+        allocate();
+    }
+
+    // Матрица поверх отображенного файла без копирования: данные начинаются с offset
+    MatrixDense(shared_ptr<MappedFile> file, size_t offset, unsigned m, unsigned n)
+        : __data(reinterpret_cast<T*>(const_cast<char*>(file->begin() + offset))), __mapping(move(file)), _m(m), _n(n) {}
+
+    // Копия всегда владеет собственным буфером (в том числе копия отображенной матрицы)
+    MatrixDense(const MatrixDense& other) : _m(other._m), _n(other._n) {
+        allocate();
+        if (bytes() != 0) {
+            memcpy(__data, other.__data, bytes());
+        }
+    }
+
+    // Перемещение: буфер передается новому владельцу, у старого объекта обнуляется
+    MatrixDense(MatrixDense&& other) noexcept
+        : __data(other.__data), __mapping(move(other.__mapping)), __pool(other.__pool), _m(other._m), _n(other._n) {
+        other.__data = nullptr;
+        other.__pool = nullptr;
+        other._m = other._n = 0;
+    }
+
+    MatrixDense& operator=(const MatrixDense& other) {
+        if (this != &other) {
+            // Буфер той же формы переиспользуется, иначе выделяется заново
+            if (bytes() != other.bytes() || __mapping) {
+                release();
+                _m = other._m;
+                _n = other._n;
+                allocate();
+            }
+            _m = other._m;
+            _n = other._n;
+            if (bytes() != 0) {
+                memcpy(__data, other.__data, bytes());
+            }
+        }
+        return *this;
+    }
+
+    MatrixDense& operator=(MatrixDense&& other) noexcept {
+        if (this != &other) {
+            release();
+            __data = other.__data;
+            __mapping = move(other.__mapping);
+            __pool = other.__pool;
+            _m = other._m;
+            _n = other._n;
+            other.__data = nullptr;
+            other.__pool = nullptr;
+            other._m = other._n = 0;
+        }
+        return *this;
     }
 
     // Деструктор, вызываемый при уничтожении объекта
     ~MatrixDense() {
-        // Освобождение выделенной памяти для массива данных
-        if (__data!=nullptr)
-        {
-            delete[] __data; // Удаляем массив, чтобы предотвратить утечку памяти
-            __data= nullptr;
-        }
+        // Освобождение буфера (или возврат в пул), чтобы предотвратить утечку памяти
+        release();
     }
 
     // Метод для доступа к элементам матрицы
     T& getElement(unsigned i, unsigned j) const {
-        return __data[j + i * _n]; // Возвращаем элемент по индексам i и j
+        return __data[j + size_t(i) * _n]; // Возвращаем элемент по индексам i и j
+    }
+
+    // Указатель на начало данных (строки хранятся подряд)
+    T* data() const { return __data; }
+
+    unsigned rows() const { return _m; }
+    unsigned cols() const { return _n; }
+
+    // Данные отображены из бинарного файла
+    bool isMapped() const { return bool(__mapping); }
+};
+
+// Ненулевой элемент разреженной матрицы (формат координат)
+template<typename T = double>
+struct SparseEntry {
+    unsigned row;
+    unsigned col;
+    T value;
+};
+
+//Класс для разреженных матриц в формате CSR: для строки i ненулевые элементы лежат
+//в values[rowPtr[i]..rowPtr[i+1]) со столбцами colIdx, столбцы в строке упорядочены.
+//Память и время операций пропорциональны числу ненулевых элементов (nnz)
+template<typename T = double>
+class MatrixSparse {
+    unsigned _m, _n;
+    vector<size_t> _rowPtr;
+    vector<unsigned> _colIdx;
+    vector<T> _values;
+
+public:
+    MatrixSparse(unsigned m = 0, unsigned n = 0) : _m(m), _n(n), _rowPtr(size_t(m) + 1, 0) {}
+
+    // Построение из списка координат в любом порядке; повторяющиеся элементы складываются
+    static MatrixSparse fromEntries(unsigned m, unsigned n, const vector<SparseEntry<T>>& entries) {
+        MatrixSparse result(m, n);
+        // Сортировка подсчетом по строкам
+        for (const auto& e : entries) {
+            ++result._rowPtr[size_t(e.row) + 1];
+        }
+        for (size_t i = 0; i < m; ++i) {
+            result._rowPtr[i + 1] += result._rowPtr[i];
+        }
+        vector<size_t> next(result._rowPtr.begin(), result._rowPtr.end() - 1);
+        vector<pair<unsigned, T>> sorted(entries.size());
+        for (const auto& e : entries) {
+            sorted[next[e.row]++] = make_pair(e.col, e.value);
+        }
+        // Упорядочение столбцов в строках и слияние повторов
+        size_t out = 0;
+        for (size_t i = 0; i < m; ++i) {
+            size_t begin = result._rowPtr[i], end = result._rowPtr[i + 1];
+            sort(sorted.begin() + begin, sorted.begin() + end,
+                 [](const pair<unsigned, T>& a, const pair<unsigned, T>& b) { return a.first < b.first; });
+            result._rowPtr[i] = out;
+            for (size_t k = begin; k < end; ++k) {
+                if (out > result._rowPtr[i] && sorted[out - 1].first == sorted[k].first) {
+                    sorted[out - 1].second += sorted[k].second;
+                } else {
+                    sorted[out++] = sorted[k];
+                }
+            }
+        }
+        result._rowPtr[m] = out;
+        result._colIdx.resize(out);
+        result._values.resize(out);
+        for (size_t k = 0; k < out; ++k) {
+            result._colIdx[k] = sorted[k].first;
+            result._values[k] = sorted[k].second;
+        }
+        return result;
     }
 
     unsigned rows() const { return _m; }
     unsigned cols() const { return _n; }
+    size_t nnz() const { return _values.size(); }
+
+    const vector<size_t>& rowPtr() const { return _rowPtr; }
+    const vector<unsigned>& colIdx() const { return _colIdx; }
+    const vector<T>& values() const { return _values; }
+    vector<size_t>& rowPtr() { return _rowPtr; }
+    vector<unsigned>& colIdx() { return _colIdx; }
+    vector<T>& values() { return _values; }
 };
 
-// Структура для хранения матриц
+// Структура для хранения матриц. Плотная матрица хранится в matrix, разреженная
+// (isSparse) - в sparse; rows и cols заполнены в обоих случаях
 struct MatrixData {
     MatrixDense<double> matrix;
+    MatrixSparse<double> sparse;
     unsigned rows;
     unsigned cols;
+    bool isSparse;
 
     // Конструктор по умолчанию
-    MatrixData() : rows(0), cols(0), matrix(MatrixDense<double>(0, 0)) {}
+    MatrixData() : matrix(0, 0), rows(0), cols(0), isSparse(false) {}
+
+    // Число элементов (в 64 битах: rows * cols в unsigned переполняется после 4G элементов)
+    size_t elements() const { return size_t(rows) * cols; }
 };
 
 struct CalcProblemParams
 {
    string filePath1;
    string filePath2;
-   enum class operations {vv_sum, vv_sub, mm_sum};
+   string filePath3;
+   enum class operations {vv_sum, vv_sub, mm_sum, mm_mul, mv_mul, solve, expression};
    operations op;
 };
 
 //Структура для хранения значений векторов и их размерностей:
 struct VectorData {
-    vector<double> values;
-    int size = 0;
+    vector<double, AlignedAllocator<double>> values;
+    size_t size = 0;
 };
 
 struct ExportConfig {
     string path; // Путь к файлу
 };
 
-struct CalcResults {
-    VectorData result; // Результат вычислений для векторов
-    MatrixData matrixResult; // Результат вычислений для матриц
-};
+struct CalcResults {
+    VectorData result; // Результат вычислений для векторов
+    MatrixData matrixResult; // Результат вычислений для матриц
+};
+
+// Уровни логирования. Сообщения ниже LOG_MIN_LEVEL удаляются на этапе компиляции
+// (например, g++ -DLOG_MIN_LEVEL=0 включает отладочные сообщения о каждой строке файла)
+enum class LogLevel { Debug = 0, Info = 1, Warning = 2, Error = 3 };
+
+#ifndef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL 1
+#endif
+
+// Запись в лог "log.txt". Вызывающий поток только кладет сообщение в lock-free
+// кольцевой буфер, а фоновый поток собирает сообщения в пачки, форматирует
+// время (строка времени кэшируется и пересчитывается раз в секунду) и пишет
+// пачку одним вызовом write. Файл открывается один раз; при завершении
+// программы очередь дописывается до конца
+class AsyncLogger {
+private:
+    struct Record {
+        time_t time;
+        string text;
+    };
+    // Ячейка кольцевого буфера: seq показывает, чья очередь работать с ячейкой
+    struct Cell {
+        atomic<size_t> seq;
+        Record record;
+    };
+
+    static const size_t capacity = 1 << 14; // Степень двойки
+    vector<Cell> cells;
+    atomic<size_t> enqueuePos{0};
+    atomic<size_t> dequeuePos{0};
+    atomic<size_t> writtenPos{0};   // Сколько сообщений уже записано в файл
+    atomic<bool> stopping{false};
+    // Фоновый поток спит на условной переменной, пока очередь пуста. Писатели будят
+    // его, только если он уснул (sleeping), поэтому запись сообщения обычно не берет мьютекс
+    atomic<bool> sleeping{false};
+    mutex signalLock;
+    condition_variable wake;        // Новое сообщение или завершение
+    condition_variable written;     // Пачка записана в файл (для flush)
+    ofstream logFile;
+    thread worker;
+
+    time_t cachedTime = 0;          // Секунда, для которой сформирована строка времени
+    string cachedStamp;             // "YYYY-MM-DD HH:MM:SS - "
+
+    AsyncLogger() : cells(capacity) {
+        for (size_t i = 0; i < capacity; ++i) {
+            cells[i].seq.store(i, memory_order_relaxed);
+        }
+        logFile.open("log.txt", ios::app); // Открываем файл в режиме добавления
+        worker = thread(&AsyncLogger::run, this);
+    }
+
+    ~AsyncLogger() {
+        {
+            lock_guard<mutex> guard(signalLock);
+            stopping.store(true);
+        }
+        wake.notify_one();
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+
+    // Извлечение одного сообщения (читает только фоновый поток)
+    bool pop(Record &record) {
+        size_t pos = dequeuePos.load(memory_order_relaxed);
+        Cell &cell = cells[pos & (capacity - 1)];
+        if (cell.seq.load(memory_order_acquire) != pos + 1) {
+            return false; // Очередь пуста
+        }
+        record = move(cell.record);
+        cell.seq.store(pos + capacity, memory_order_release);
+        dequeuePos.store(pos + 1, memory_order_relaxed);
+        return true;
+    }
+
+    // В очереди есть опубликованное сообщение (seq_cst - пара к публикации в write)
+    bool pending() const {
+        size_t pos = dequeuePos.load(memory_order_relaxed);
+        return cells[pos & (capacity - 1)].seq.load() == pos + 1;
+    }
+
+    const string& stamp(time_t t) {
+        if (t != cachedTime || cachedStamp.empty()) {
+            cachedTime = t;
+            struct tm *now = localtime(&t); // Преобразую в локальное время
+            ostringstream out;
+            out << put_time(now, "%Y-%m-%d %H:%M:%S") << " - ";
+            cachedStamp = out.str();
+        }
+        return cachedStamp;
+    }
+
+    void run() {
+        string batch;
+        Record record;
+        for (;;) {
+            bool stop = stopping.load();
+            size_t count = 0;
+            while (batch.size() < (1 << 20) && pop(record)) {
+                batch += stamp(record.time);
+                batch += record.text;
+                batch += '\n';
+                ++count;
+            }
+            if (count > 0) {
+                if (logFile) {
+                    logFile.write(batch.data(), batch.size());
+                    logFile.flush();
+                }
+                batch.clear();
+                {
+                    lock_guard<mutex> guard(signalLock);
+                    writtenPos.fetch_add(count);
+                }
+                written.notify_all();
+                continue;
+            }
+            if (stop) {
+                break; // Очередь пуста и пришел сигнал завершения
+            }
+            unique_lock<mutex> guard(signalLock);
+            sleeping.store(true);
+            wake.wait(guard, [&]() { return stopping.load() || pending(); });
+            sleeping.store(false);
+        }
+    }
+
+public:
+    static AsyncLogger& instance() {
+        static AsyncLogger logger;
+        return logger;
+    }
+
+    AsyncLogger(const AsyncLogger&) = delete;
+    AsyncLogger& operator=(const AsyncLogger&) = delete;
+
+    // Добавление сообщения; если буфер заполнен, поток ждет, пока логгер его разгрузит
+    void write(string data) {
+        time_t t = time(0); // Получаю текущее время
+        size_t pos = enqueuePos.load(memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &cells[pos & (capacity - 1)];
+            size_t seq = cell->seq.load(memory_order_acquire);
+            intptr_t diff = intptr_t(seq) - intptr_t(pos);
+            if (diff == 0) {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                this_thread::yield(); // Буфер заполнен
+                pos = enqueuePos.load(memory_order_relaxed);
+            } else {
+                pos = enqueuePos.load(memory_order_relaxed);
+            }
+        }
+        cell->record.time = t;
+        cell->record.text = move(data);
+        // Публикация и чтение sleeping упорядочены (seq_cst): либо фоновый поток увидит
+        // сообщение при проверке перед сном, либо писатель увидит, что поток спит
+        cell->seq.store(pos + 1);
+        if (sleeping.load()) {
+            lock_guard<mutex> guard(signalLock);
+            wake.notify_one();
+        }
+    }
+
+    // Ожидание записи в файл всех сообщений, добавленных до вызова
+    void flush() {
+        size_t target = enqueuePos.load();
+        unique_lock<mutex> guard(signalLock);
+        written.wait(guard, [&]() { return writtenPos.load() >= target; });
+    }
+};
+
+// Макрос не вычисляет текст сообщения, если уровень ниже порога
+#define LOG_AT(level, data) \
+    do { \
+        if (int(level) >= LOG_MIN_LEVEL) { \
+            AsyncLogger::instance().write(data); \
+        } \
+    } while (0)
+
+#define LOG_DEBUG(data) LOG_AT(LogLevel::Debug, data)
+#define LOG_INFO(data) LOG_AT(LogLevel::Info, data)
+#define LOG_WARNING(data) LOG_AT(LogLevel::Warning, data)
+#define LOG_ERROR(data) LOG_AT(LogLevel::Error, data)
+
+// Постоянный пул потоков для всех параллельных операций. Потоки создаются один раз
+// и ждут работу на условной переменной, поэтому параллельный участок не создает потоков.
+// Вызывающий поток работает как поток номер 0. Вложенный вызов из задачи пула
+// (например, умножение внутри задания пакетного режима) выполняется последовательно
+class ThreadPool {
+private:
+    vector<thread> threads;
+    mutex runLock; // Одновременно выполняется один параллельный участок
+    mutex lock;
+    condition_variable wake, done;
+    const function<void(size_t, size_t)>* job = nullptr;
+    size_t jobCount = 0;
+    bool jobStatic = false;
+    atomic<size_t> next{0};
+    size_t generation = 0;
+    size_t busy = 0;
+    bool stopping = false;
+    exception_ptr failure; // Первое исключение задачи, передается вызывающему потоку
+
+    static bool& insideTask() {
+        thread_local bool inside = false;
+        return inside;
+    }
+
+    // Исключение задачи не выходит за пределы work: поток прекращает брать задачи,
+    // а run дожидается остальных потоков и передает исключение вызывающему
+    void work(size_t id) {
+        try {
+            if (jobStatic) {
+                // Задача t всегда выполняется потоком t % size(): одинаковые диапазоны памяти
+                // при повторных вызовах обрабатывает один и тот же поток
+                for (size_t task = id; task < jobCount; task += size()) {
+                    (*job)(task, id);
+                }
+            } else {
+                for (size_t task = next++; task < jobCount; task = next++) {
+                    (*job)(task, id);
+                }
+            }
+        } catch (...) {
+            next = jobCount; // Оставшиеся задачи не раздаются
+            lock_guard<mutex> guard(lock);
+            if (!failure) {
+                failure = current_exception();
+            }
+        }
+    }
+
+    void loop(size_t id) {
+        insideTask() = true;
+        size_t seen = 0;
+        unique_lock<mutex> guard(lock);
+        while (true) {
+            wake.wait(guard, [&]() { return stopping || generation != seen; });
+            if (stopping) {
+                return;
+            }
+            seen = generation;
+            guard.unlock();
+            work(id);
+            guard.lock();
+            if (--busy == 0) {
+                done.notify_one();
+            }
+        }
+    }
+
+public:
+    explicit ThreadPool(size_t count) {
+        for (size_t id = 1; id < count; ++id) {
+            threads.emplace_back(&ThreadPool::loop, this, id);
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            lock_guard<mutex> guard(lock);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& th : threads) {
+            th.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    static ThreadPool& instance() {
+        static ThreadPool pool(max<size_t>(1, thread::hardware_concurrency()));
+        return pool;
+    }
+
+    size_t size() const { return threads.size() + 1; }
+
+    // body(задача, номер потока) для задач 0..count-1. staticSchedule закрепляет задачи
+    // за потоками, иначе задачи раздаются через атомарный счетчик
+    void run(size_t count, const function<void(size_t, size_t)>& body, bool staticSchedule = false) {
+        if (insideTask() || threads.empty() || count <= 1) {
+            for (size_t task = 0; task < count; ++task) {
+                body(task, 0);
+            }
+            return;
+        }
+        lock_guard<mutex> exclusive(runLock);
+        {
+            lock_guard<mutex> guard(lock);
+            job = &body;
+            jobCount = count;
+            jobStatic = staticSchedule;
+            next = 0;
+            busy = threads.size();
+            ++generation;
+        }
+        wake.notify_all();
+        insideTask() = true;
+        work(0);
+        insideTask() = false;
+        unique_lock<mutex> guard(lock);
+        done.wait(guard, [&]() { return busy == 0; });
+        if (failure) {
+            exception_ptr error = failure;
+            failure = nullptr;
+            rethrow_exception(error);
+        }
+    }
+};
+
+// Число потоков пула (включая вызывающий)
+size_t parallelWorkers() {
+    return ThreadPool::instance().size();
+}
+
+// Выполнение count задач на пуле: body(задача, номер потока)
+void parallelTasks(size_t count, const function<void(size_t, size_t)>& body) {
+    ThreadPool::instance().run(count, body);
+}
+
+// Деление [0, n) на parallelWorkers() диапазонов, кратных align элементам; диапазон t
+// всегда обрабатывает поток t, поэтому первое касание страниц результата и последующие
+// проходы по ним выполняются одним и тем же потоком (и узлом NUMA)
+void parallelRanges(size_t n, size_t align, const function<void(size_t, size_t)>& body) {
+    size_t workers = parallelWorkers();
+    ThreadPool::instance().run(workers, [&](size_t task, size_t) {
+        size_t begin = min(n, n / workers * task / align * align);
+        size_t end = task + 1 == workers ? n : min(n, n / workers * (task + 1) / align * align);
+        if (begin < end) {
+            body(begin, end);
+        }
+    }, true);
+}
+
+// Выделение очередной строки [lineBegin, lineEnd) без '\n' и '\r'; p сдвигается на следующую строку
+bool nextLine(const char*& p, const char* end, const char*& lineBegin, const char*& lineEnd) {
+    if (p >= end) {
+        return false;
+    }
+    lineBegin = p;
+    const char* nl = static_cast<const char*>(memchr(p, '\n', end - p));
+    lineEnd = nl ? nl : end;
+    p = nl ? nl + 1 : end;
+    if (lineEnd > lineBegin && lineEnd[-1] == '\r') {
+        --lineEnd;
+    }
+    return true;
+}
+
+bool lineEquals(const char* b, const char* e, const char* text) {
+    size_t n = strlen(text);
+    return size_t(e - b) == n && memcmp(b, text, n) == 0;
+}
+
+// Разбор до count чисел из строки через from_chars (без учета локали и без выделения памяти).
+// Возвращает число прочитанных значений; в stop (если задан) - позицию после последнего
+size_t parseValues(const char* p, const char* end, double* out, size_t count, const char** stop = nullptr) {
+    size_t k = 0;
+    while (k < count) {
+        while (p < end && (*p == ' ' || *p == '\t')) {
+            ++p;
+        }
+        if (p < end && *p == '+') {
+            ++p; // from_chars не принимает ведущий '+'
+        }
+        auto res = from_chars(p, end, out[k]);
+        if (res.ec != errc()) {
+            break;
+        }
+        p = res.ptr;
+        ++k;
+    }
+    if (stop != nullptr) {
+        *stop = p;
+    }
+    return k;
+}
+
+// Остаток строки [p, end) пуст или состоит из пробелов
+bool onlySpaces(const char* p, const char* end) {
+    while (p < end && (*p == ' ' || *p == '\t')) {
+        ++p;
+    }
+    return p == end;
+}
+
+// Разбор натурального числа, за которым идет символ stop (или конец строки)
+bool parseSize(const char*& p, const char* end, size_t& value) {
+    while (p < end && (*p == ' ' || *p == '\t')) {
+        ++p;
+    }
+    auto res = from_chars(p, end, value);
+    if (res.ec != errc()) {
+        return false;
+    }
+    p = res.ptr;
+    while (p < end && (*p == ' ' || *p == '\t')) {
+        ++p;
+    }
+    return true;
+}
+
+//Функция для чтения из файлов и проверки значений (формат "vector / N / значения")
+VectorData readDataFromFile(const string& filepath) {
+    VectorData vectorData;
+    MappedFile file(filepath);
+    if (!file.isOpen()) {
+        LOG_ERROR("Ошибка открытия файла");
+        return vectorData; // Возвращаем пустой вектор
+    }
+
+    const char* p = file.begin();
+    const char* lb;
+    const char* le;
+    while (nextLine(p, file.end(), lb, le)) {
+        if (lineEquals(lb, le, "vector")) {
+            LOG_INFO("В файле обнаружено значение vector");
+            // Читаем размер вектора
+            size_t n = 0;
+            if (!nextLine(p, file.end(), lb, le) || !parseSize(lb, le, n) || lb != le) {
+                LOG_ERROR("Ошибка: неверный размер вектора");
+                return VectorData();
+            }
+            // Каждое значение занимает не меньше двух байт (цифра и разделитель): размер
+            // сверяется с остатком файла до выделения памяти
+            if (n > (size_t(file.end() - p) + 1) / 2) {
+                LOG_ERROR("Ошибка: размер вектора " + to_string(n) + " больше, чем помещается в файле");
+                return VectorData();
+            }
+            vectorData.size = n;
+            vectorData.values.resize(n);
+            // Читаем значения вектора
+            if (nextLine(p, file.end(), lb, le) &&
+                parseValues(lb, le, vectorData.values.data(), n) == n) {
+                return vectorData;
+            }
+            LOG_ERROR("Ошибка: не удалось прочитать значения вектора, ожидалось " + to_string(n));
+            return VectorData();
+        }
+    }
+    return vectorData;
+}
+
+// Разбор строк матрицы из [begin, end) прямо в хранилище MatrixDense.
+// Для больших файлов диапазон делится на куски по границам строк, первый проход
+// считает строки в каждом куске (чтобы знать номер первой строки куска),
+// второй - параллельно разбирает куски. Возвращает пустую строку или текст ошибки
+string parseMatrixRows(const char* begin, const char* end, MatrixDense<double>& matrix, size_t rows, size_t cols) {
+    const size_t minChunkBytes = size_t(4) << 20;
+    size_t threadCount = parallelWorkers();
+    threadCount = max<size_t>(1, min(threadCount, size_t(end - begin) / minChunkBytes));
+
+    // Границы кусков выравниваются на начало строки
+    vector<const char*> bounds(threadCount + 1);
+    bounds[0] = begin;
+    bounds[threadCount] = end;
+    for (size_t t = 1; t < threadCount; ++t) {
+        const char* b = begin + (end - begin) * t / threadCount;
+        b = max(b, bounds[t - 1]);
+        const char* nl = static_cast<const char*>(memchr(b, '\n', end - b));
+        bounds[t] = nl ? nl + 1 : end;
+    }
+
+    // Проход 1: число строк в каждом куске
+    vector<size_t> firstRow(threadCount + 1, 0);
+    parallelTasks(threadCount, [&](size_t t, size_t) {
+        size_t lines = 0;
+        for (const char* q = bounds[t]; q < bounds[t + 1];) {
+            const char* nl = static_cast<const char*>(memchr(q, '\n', bounds[t + 1] - q));
+            ++lines; // Последняя строка может быть без '\n'
+            q = nl ? nl + 1 : bounds[t + 1];
+        }
+        firstRow[t + 1] = lines;
+    });
+    for (size_t t = 0; t < threadCount; ++t) {
+        firstRow[t + 1] += firstRow[t];
+    }
+    if (firstRow[threadCount] < rows) {
+        return "Ошибка: недостаточно строк для матрицы. Ожидалось " + to_string(rows) + " строк.";
+    }
+
+    // Проход 2: разбор; каждый поток запоминает первую ошибку в своем куске
+    vector<size_t> errorRow(threadCount, SIZE_MAX), errorCol(threadCount, 0);
+    parallelTasks(threadCount, [&](size_t t, size_t) {
+        const char* q = bounds[t];
+        const char* lb;
+        const char* le;
+        for (size_t i = firstRow[t]; i < rows && nextLine(q, bounds[t + 1], lb, le); ++i) {
+            const char* stop = lb;
+            size_t parsed = parseValues(lb, le, matrix.data() + i * cols, cols, &stop);
+            if (parsed != cols || !onlySpaces(stop, le)) { // Лишние значения в строке - тоже ошибка
+                errorRow[t] = i;
+                errorCol[t] = parsed;
+                return;
+            }
+        }
+    });
+    for (size_t t = 0; t < threadCount; ++t) {
+        if (errorRow[t] != SIZE_MAX) {
+            return "Ошибка: не удалось прочитать элемент матрицы на позиции (" + to_string(errorRow[t]) + ", " + to_string(errorCol[t]) + ")";
+        }
+    }
+    return "";
+}
+
+// Заголовок бинарного формата матрицы. За ним с dataOffset идут элементы построчно.
+// dataOffset кратен alignment, поэтому после отображения файла (начало отображения
+// выровнено на страницу) данные выровнены так же, как при выделении под SIMD
+struct MatrixFileHeader {
+    char magic[8];       // "MTXBIN1"
+    uint32_t byteOrder;  // 0x01020304 в порядке байт записавшей машины
+    uint32_t dtype;      // Тип элементов, см. MatrixFileDType
+    uint32_t elemSize;   // Размер элемента в байтах
+    uint32_t alignment;  // Выравнивание данных в файле
+    uint64_t rows;
+    uint64_t cols;
+    uint64_t dataOffset; // Смещение начала данных от начала файла
+    char reserved[16];
+};
+static_assert(sizeof(MatrixFileHeader) == 64, "Заголовок бинарной матрицы должен занимать 64 байта");
+
+enum MatrixFileDType : uint32_t { DTypeFloat64 = 1 };
+
+const char MATRIX_BINARY_MAGIC[8] = "MTXBIN1";
+const uint32_t MATRIX_BINARY_BYTE_ORDER = 0x01020304;
+const uint32_t MATRIX_BINARY_ALIGNMENT = 64;
+
+// Заголовок бинарного формата разреженной матрицы. С dataOffset идут rowPtr (rows + 1
+// значений uint64), затем colIdx (nnz значений uint32), затем values (nnz значений);
+// каждый массив начинается с границы alignment
+struct SparseFileHeader {
+    char magic[8];       // "MTXSPR1"
+    uint32_t byteOrder;
+    uint32_t dtype;
+    uint32_t elemSize;
+    uint32_t alignment;
+    uint64_t rows;
+    uint64_t cols;
+    uint64_t nnz;
+    uint64_t dataOffset;
+    char reserved[8];
+};
+static_assert(sizeof(SparseFileHeader) == 64, "Заголовок бинарной разреженной матрицы должен занимать 64 байта");
+
+const char SPARSE_BINARY_MAGIC[8] = "MTXSPR1";
+
+bool isBinaryMatrix(const char* begin, const char* end) {
+    return size_t(end - begin) >= sizeof(MatrixFileHeader) &&
+           (memcmp(begin, MATRIX_BINARY_MAGIC, sizeof(MATRIX_BINARY_MAGIC)) == 0 ||
+            memcmp(begin, SPARSE_BINARY_MAGIC, sizeof(SPARSE_BINARY_MAGIC)) == 0);
+}
+
+size_t alignUp(size_t offset, size_t alignment) {
+    return (offset + alignment - 1) / alignment * alignment;
+}
+
+// Смещения массивов rowPtr, colIdx и values в бинарном файле разреженной матрицы
+void sparseBinaryLayout(const SparseFileHeader& header, size_t& rowPtrOffset, size_t& colIdxOffset, size_t& valuesOffset, size_t& totalSize) {
+    rowPtrOffset = header.dataOffset;
+    colIdxOffset = alignUp(rowPtrOffset + (header.rows + 1) * sizeof(uint64_t), MATRIX_BINARY_ALIGNMENT);
+    valuesOffset = alignUp(colIdxOffset + header.nnz * sizeof(uint32_t), MATRIX_BINARY_ALIGNMENT);
+    totalSize = valuesOffset + header.nnz * sizeof(double);
+}
+
+// Загрузка бинарной разреженной матрицы (массивы копируются из отображения одним memcpy)
+MatrixData readSparseBinary(const MappedFile& file, const string& filepath) {
+    SparseFileHeader header;
+    memcpy(&header, file.begin(), sizeof(header));
+    if (header.byteOrder != MATRIX_BINARY_BYTE_ORDER || header.dtype != DTypeFloat64 || header.elemSize != sizeof(double)) {
+        LOG_ERROR("Ошибка: неподдерживаемый порядок байт или тип элементов разреженной матрицы: " + filepath);
+        return MatrixData();
+    }
+    size_t rowPtrOffset = 0, colIdxOffset = 0, valuesOffset = 0, totalSize = 0;
+    if (header.rows > UINT32_MAX || header.cols > UINT32_MAX || header.nnz > file.size() ||
+        header.dataOffset < sizeof(header) || header.dataOffset > file.size()) {
+        LOG_ERROR("Ошибка: поврежден заголовок разреженной матрицы или файл обрезан: " + filepath);
+        return MatrixData();
+    }
+    sparseBinaryLayout(header, rowPtrOffset, colIdxOffset, valuesOffset, totalSize);
+    if (totalSize > file.size()) {
+        LOG_ERROR("Ошибка: поврежден заголовок разреженной матрицы или файл обрезан: " + filepath);
+        return MatrixData();
+    }
+
+    MatrixData matrixData;
+    matrixData.rows = unsigned(header.rows);
+    matrixData.cols = unsigned(header.cols);
+    matrixData.isSparse = true;
+    matrixData.sparse = MatrixSparse<double>(matrixData.rows, matrixData.cols);
+    auto& rowPtr = matrixData.sparse.rowPtr();
+    auto& colIdx = matrixData.sparse.colIdx();
+    auto& values = matrixData.sparse.values();
+    colIdx.resize(header.nnz);
+    values.resize(header.nnz);
+    for (size_t i = 0; i <= header.rows; ++i) {
+        uint64_t offset;
+        memcpy(&offset, file.begin() + rowPtrOffset + i * sizeof(uint64_t), sizeof(offset));
+        rowPtr[i] = size_t(offset);
+    }
+    memcpy(colIdx.data(), file.begin() + colIdxOffset, header.nnz * sizeof(uint32_t));
+    memcpy(values.data(), file.begin() + valuesOffset, header.nnz * sizeof(double));
+
+    // Проверка структуры, чтобы поврежденный файл не приводил к выходу за границы
+    bool valid = rowPtr[0] == 0 && rowPtr[header.rows] == header.nnz;
+    for (size_t i = 0; valid && i < header.rows; ++i) {
+        valid = rowPtr[i] <= rowPtr[i + 1];
+    }
+    for (size_t k = 0; valid && k < header.nnz; ++k) {
+        valid = colIdx[k] < header.cols;
+    }
+    if (!valid) {
+        LOG_ERROR("Ошибка: нарушена структура CSR в файле: " + filepath);
+        return MatrixData();
+    }
+    LOG_INFO("Бинарная разреженная матрица: " + to_string(header.rows) + "x" + to_string(header.cols) + ", ненулевых: " + to_string(header.nnz));
+    return matrixData;
+}
+
+// Имя временного файла рядом с path для записи с заменой (replaceFile)
+string temporaryPathFor(const string& path) {
+    static atomic<unsigned> counter{0};
+#ifdef _WIN32
+    unsigned long pid = GetCurrentProcessId();
+#else
+    unsigned long pid = (unsigned long)getpid();
+#endif
+    return path + ".tmp" + to_string(pid) + "_" + to_string(counter++);
+}
+
+// Замена path записанным временным файлом. Прежний файл не усекается, а только теряет имя,
+// поэтому матрица, отображенная из него в память (readMatrixBinary), остается прежней
+// и не получает SIGBUS, даже если задание перезаписывает собственный операнд
+bool replaceFile(const string& temporary, const string& path) {
+#ifdef _WIN32
+    bool ok = MoveFileExA(temporary.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    bool ok = rename(temporary.c_str(), path.c_str()) == 0;
+#endif
+    if (!ok) {
+        remove(temporary.c_str());
+        LOG_ERROR("Ошибка замены файла: " + path);
+    }
+    return ok;
+}
+
+// Завершение записи во временный файл: при ошибке он удаляется, иначе заменяет path
+int finishReplace(ofstream& out, const string& temporary, const string& path, const string& error) {
+    out.close();
+    if (!out) {
+        remove(temporary.c_str());
+        LOG_ERROR(error + path);
+        return -1;
+    }
+    return replaceFile(temporary, path) ? 0 : -1;
+}
+
+int writeSparseBinary(const string& path, const MatrixData& matrixData) {
+    const string temporary = temporaryPathFor(path);
+    ofstream out(temporary, ios::binary | ios::trunc);
+    if (!out) {
+        LOG_ERROR("Ошибка открытия файла: " + path);
+        return -1;
+    }
+    const MatrixSparse<double>& sparse = matrixData.sparse;
+    SparseFileHeader header = {};
+    memcpy(header.magic, SPARSE_BINARY_MAGIC, sizeof(header.magic));
+    header.byteOrder = MATRIX_BINARY_BYTE_ORDER;
+    header.dtype = DTypeFloat64;
+    header.elemSize = sizeof(double);
+    header.alignment = MATRIX_BINARY_ALIGNMENT;
+    header.rows = sparse.rows();
+    header.cols = sparse.cols();
+    header.nnz = sparse.nnz();
+    header.dataOffset = alignUp(sizeof(header), MATRIX_BINARY_ALIGNMENT);
+    size_t rowPtrOffset = 0, colIdxOffset = 0, valuesOffset = 0, totalSize = 0;
+    sparseBinaryLayout(header, rowPtrOffset, colIdxOffset, valuesOffset, totalSize);
+
+    auto pad = [&](size_t offset) {
+        while (size_t(out.tellp()) < offset) {
+            out.put('\0');
+        }
+    };
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    pad(rowPtrOffset);
+    vector<uint64_t> rowPtr(sparse.rowPtr().begin(), sparse.rowPtr().end());
+    out.write(reinterpret_cast<const char*>(rowPtr.data()), streamsize(rowPtr.size() * sizeof(uint64_t)));
+    pad(colIdxOffset);
+    out.write(reinterpret_cast<const char*>(sparse.colIdx().data()), streamsize(sparse.nnz() * sizeof(uint32_t)));
+    pad(valuesOffset);
+    out.write(reinterpret_cast<const char*>(sparse.values().data()), streamsize(sparse.nnz() * sizeof(double)));
+    return finishReplace(out, temporary, path, "Ошибка записи разреженной матрицы: ");
+}
+
+// Разбор разреженной матрицы после строки "sparse": размеры "MxN nnz" и nnz строк "i j значение"
+MatrixData parseSparseText(const char*& p, const char* end) {
+    const char* lb;
+    const char* le;
+    size_t rows = 0, cols = 0, nnz = 0;
+    if (!nextLine(p, end, lb, le) || !parseSize(lb, le, rows) || lb == le || *lb++ != 'x' ||
+        !parseSize(lb, le, cols) || !parseSize(lb, le, nnz) || lb != le || rows > UINT32_MAX || cols > UINT32_MAX) {
+        LOG_ERROR("Ошибка: неверный формат размеров разреженной матрицы. Ожидалось 'MxN nnz'.");
+        return MatrixData();
+    }
+    LOG_INFO("Размеры разреженной матрицы: " + to_string(rows) + "x" + to_string(cols) + ", ненулевых: " + to_string(nnz));
+
+    vector<SparseEntry<double>> entries;
+    entries.reserve(min(nnz, size_t(end - p) / 6 + 1)); // Не доверяем nnz из файла больше, чем размеру файла
+    for (size_t k = 0; k < nnz; ++k) {
+        size_t row = 0, col = 0;
+        double value = 0;
+        if (!nextLine(p, end, lb, le) || !parseSize(lb, le, row) || !parseSize(lb, le, col) ||
+            parseValues(lb, le, &value, 1) != 1 || row >= rows || col >= cols) {
+            LOG_ERROR("Ошибка: не удалось прочитать ненулевой элемент номер " + to_string(k));
+            return MatrixData();
+        }
+        entries.push_back(SparseEntry<double>{unsigned(row), unsigned(col), value});
+    }
+
+    MatrixData matrixData;
+    matrixData.rows = unsigned(rows);
+    matrixData.cols = unsigned(cols);
+    matrixData.isSparse = true;
+    matrixData.sparse = MatrixSparse<double>::fromEntries(matrixData.rows, matrixData.cols, entries);
+    return matrixData;
+}
+
+// Загрузка бинарной матрицы без копирования: MatrixDense ссылается на отображенный файл
+MatrixData readMatrixBinary(const shared_ptr<MappedFile>& file, const string& filepath) {
+    MatrixFileHeader header;
+    memcpy(&header, file->begin(), sizeof(header));
+    if (header.byteOrder != MATRIX_BINARY_BYTE_ORDER) {
+        LOG_ERROR("Ошибка: бинарная матрица записана с другим порядком байт: " + filepath);
+        return MatrixData();
+    }
+    if (header.dtype != DTypeFloat64 || header.elemSize != sizeof(double)) {
+        LOG_ERROR("Ошибка: неподдерживаемый тип элементов бинарной матрицы: " + filepath);
+        return MatrixData();
+    }
+    if (header.dataOffset % alignof(double) != 0 || header.dataOffset < sizeof(header) || header.dataOffset > file->size() ||
+        header.rows > UINT32_MAX || header.cols > UINT32_MAX ||
+        (header.cols != 0 && header.rows > (file->size() - header.dataOffset) / sizeof(double) / header.cols)) {
+        LOG_ERROR("Ошибка: поврежден заголовок бинарной матрицы или файл обрезан: " + filepath);
+        return MatrixData();
+    }
+    LOG_INFO("Бинарная матрица: " + to_string(header.rows) + "x" + to_string(header.cols));
+
+    MatrixData matrixData;
+    matrixData.rows = unsigned(header.rows);
+    matrixData.cols = unsigned(header.cols);
+    matrixData.matrix = MatrixDense<double>(file, header.dataOffset, matrixData.rows, matrixData.cols);
+    return matrixData;
+}
+
+// Запись матрицы в бинарном формате (заголовок, выравнивание, данные построчно).
+// Файл заменяется целиком через временный, см. replaceFile
+int writeMatrixBinary(const string& path, const MatrixData& matrixData) {
+    if (matrixData.isSparse) {
+        return writeSparseBinary(path, matrixData);
+    }
+    const string temporary = temporaryPathFor(path);
+    ofstream out(temporary, ios::binary | ios::trunc);
+    if (!out) {
+        LOG_ERROR("Ошибка открытия файла: " + path);
+        return -1;
+    }
+    MatrixFileHeader header = {};
+    memcpy(header.magic, MATRIX_BINARY_MAGIC, sizeof(header.magic));
+    header.byteOrder = MATRIX_BINARY_BYTE_ORDER;
+    header.dtype = DTypeFloat64;
+    header.elemSize = sizeof(double);
+    header.alignment = MATRIX_BINARY_ALIGNMENT;
+    header.rows = matrixData.rows;
+    header.cols = matrixData.cols;
+    header.dataOffset = (sizeof(header) + MATRIX_BINARY_ALIGNMENT - 1) / MATRIX_BINARY_ALIGNMENT * MATRIX_BINARY_ALIGNMENT;
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (size_t k = sizeof(header); k < header.dataOffset; ++k) {
+        out.put('\0');
+    }
+    out.write(reinterpret_cast<const char*>(matrixData.matrix.data()), streamsize(size_t(matrixData.rows) * matrixData.cols * sizeof(double)));
+    return finishReplace(out, temporary, path, "Ошибка записи бинарной матрицы: ");
+}
+
+//Функция для чтения данных матрицы из файла. Формат определяется автоматически:
+//бинарный файл отображается в память и используется без копирования, текстовый
+//("matrix / MxN / строки") разбирается через from_chars прямо в хранилище матрицы,
+//разреженный ("sparse / MxN nnz / i j значение", текстовый или бинарный) читается в CSR
+MatrixData readMatrixFromFile(const string& filepath) {
+    MatrixData matrixData;
+    auto mapped = make_shared<MappedFile>(filepath, true);
+    const MappedFile& file = *mapped;
+    if (!file.isOpen()) {
+        LOG_ERROR("Ошибка открытия файла: " + filepath);
+        return matrixData;
+    }
+    if (isBinaryMatrix(file.begin(), file.end())) {
+        if (memcmp(file.begin(), SPARSE_BINARY_MAGIC, sizeof(SPARSE_BINARY_MAGIC)) == 0) {
+            return readSparseBinary(file, filepath);
+        }
+        return readMatrixBinary(mapped, filepath);
+    }
+
+    const char* p = file.begin();
+    const char* lb;
+    const char* le;
+    while (nextLine(p, file.end(), lb, le)) {
+        if (lineEquals(lb, le, "sparse")) {
+            LOG_INFO("В файле обнаружено значение 'sparse'");
+            return parseSparseText(p, file.end());
+        }
+        if (!lineEquals(lb, le, "matrix")) {
+            continue;
+        }
+        LOG_INFO("В файле обнаружено значение 'matrix'");
+        size_t rows = 0, cols = 0;
+        if (!nextLine(p, file.end(), lb, le) || !parseSize(lb, le, rows) ||
+            lb == le || *lb++ != 'x' || !parseSize(lb, le, cols) || lb != le || rows > UINT32_MAX || cols > UINT32_MAX) {
+            LOG_ERROR("Ошибка: неверный формат размеров матрицы. Ожидалось 'MxN'.");
+            return MatrixData(); // Возвращаем пустую матрицу в случае ошибки
+        }
+        LOG_INFO("Размеры матрицы: " + to_string(rows) + "x" + to_string(cols));
+        // Как и для вектора: не меньше двух байт на значение, иначе файл обрезан или размеры неверны
+        if (rows * cols > (size_t(file.end() - p) + 1) / 2) {
+            LOG_ERROR("Ошибка: размеры матрицы " + to_string(rows) + "x" + to_string(cols) + " больше, чем помещается в файле");
+            return MatrixData();
+        }
+
+        matrixData.rows = unsigned(rows);
+        matrixData.cols = unsigned(cols);
+        matrixData.matrix = MatrixDense<double>(matrixData.rows, matrixData.cols);
+        string error = parseMatrixRows(p, file.end(), matrixData.matrix, rows, cols);
+        if (!error.empty()) {
+            LOG_ERROR(error);
+            return MatrixData(); // Возвращаем пустую матрицу в случае ошибки
+        }
+        return matrixData;
+    }
+    return matrixData;
+}
+
+//Прежний разбор матрицы через getline и istringstream, оставлен для сравнения в бенчмарках
+MatrixData readMatrixFromFileStream(const string& filepath) {
+    string line;
+    MatrixData matrixData;
+    ifstream dataFile(filepath);
+    
+    if (!dataFile) {
+        LOG_ERROR("Ошибка открытия файла: " + filepath);
+        return matrixData;
+    }
+
+    while (getline(dataFile, line)) {
+        LOG_DEBUG("Чтение строки: " + line);
+        if (line == "matrix") {
+            LOG_INFO("В файле обнаружено значение 'matrix'");
+            if (getline(dataFile, line)) {
+                // Изменяем формат чтения размеров матрицы
+                size_t xPos = line.find('x');
+                if (xPos != string::npos) {
+                    matrixData.rows = stoi(line.substr(0, xPos));
+                    matrixData.cols = stoi(line.substr(xPos + 1));
+                    LOG_INFO("Размеры матрицы: " + to_string(matrixData.rows) + "x" + to_string(matrixData.cols));
+                } else {
+                    LOG_ERROR("Ошибка: неверный формат размеров матрицы. Ожидалось 'MxN'.");
+                    return matrixData; // Возвращаем пустую матрицу в случае ошибки
+                }
+                
+                matrixData.matrix = MatrixDense<double>(matrixData.rows, matrixData.cols);
+                
+                // Читаем значения матрицы
+                for (unsigned i = 0; i < matrixData.rows; ++i) {
+                    if (getline(dataFile, line)) {
+                        LOG_DEBUG("Чтение строки матрицы: " + line);
+                        istringstream iss(line);
+                        for (unsigned j = 0; j < matrixData.cols; ++j) {
+                            if (!(iss >> matrixData.matrix.getElement(i, j))) {
+                                LOG_ERROR("Ошибка: не удалось прочитать элемент матрицы на позиции (" + to_string(i) + ", " + to_string(j) + ")");
+                                return matrixData; // Возвращаем пустую матрицу в случае ошибки
+                            }
+                        }
+                    } else {
+                        LOG_ERROR("Ошибка: недостаточно строк для матрицы. Ожидалось " + to_string(matrixData.rows) + " строк.");
+                        return matrixData; // Возвращаем пустую матрицу в случае ошибки
+                    }
+                }
+            }
+        }
+    }
+    
+    dataFile.close();
+    return matrixData;
+}
+
+// Разбиение строк CSR на count диапазонов с примерно равной работой (ненулевые плюс строки)
+vector<size_t> sparseRowRanges(const MatrixSparse<double>& a, size_t count) {
+    const vector<size_t>& rowPtr = a.rowPtr();
+    size_t rows = a.rows();
+    size_t total = rowPtr[rows] + rows;
+    vector<size_t> bounds(count + 1, rows);
+    bounds[0] = 0;
+    for (size_t t = 1; t < count; ++t) {
+        size_t target = total * t / count;
+        size_t lo = bounds[t - 1], hi = rows;
+        while (lo < hi) { // Первая строка i, у которой rowPtr[i] + i >= target
+            size_t mid = (lo + hi) / 2;
+            if (rowPtr[mid] + mid < target) lo = mid + 1; else hi = mid;
+        }
+        bounds[t] = lo;
+    }
+    return bounds;
+}
+
+// Параллельный обход строк CSR: body(первая строка, последняя строка)
+void parallelSparseRows(const MatrixSparse<double>& a, const function<void(size_t, size_t)>& body) {
+    size_t tasks = max<size_t>(1, min<size_t>(a.rows(), parallelWorkers() * 8));
+    vector<size_t> bounds = sparseRowRanges(a, tasks);
+    parallelTasks(tasks, [&](size_t task, size_t) { body(bounds[task], bounds[task + 1]); });
+}
+
+// Сумма разреженных матриц: слияние упорядоченных строк. Первый проход считает
+// число элементов в каждой строке результата, второй заполняет CSR
+MatrixSparse<double> addSparse(const MatrixSparse<double>& a, const MatrixSparse<double>& b) {
+    MatrixSparse<double> c(a.rows(), a.cols());
+    vector<size_t>& rowPtr = c.rowPtr();
+    auto mergeRow = [&](size_t i, unsigned* cols, double* values) {
+        size_t ka = a.rowPtr()[i], ea = a.rowPtr()[i + 1];
+        size_t kb = b.rowPtr()[i], eb = b.rowPtr()[i + 1];
+        size_t count = 0;
+        while (ka < ea || kb < eb) {
+            unsigned ca = ka < ea ? a.colIdx()[ka] : UINT32_MAX;
+            unsigned cb = kb < eb ? b.colIdx()[kb] : UINT32_MAX;
+            unsigned col = min(ca, cb);
+            double value = 0;
+            if (ca == col) value += a.values()[ka++];
+            if (cb == col) value += b.values()[kb++];
+            if (cols != nullptr) {
+                cols[count] = col;
+                values[count] = value;
+            }
+            ++count;
+        }
+        return count;
+    };
+    parallelSparseRows(a, [&](size_t first, size_t last) {
+        for (size_t i = first; i < last; ++i) {
+            rowPtr[i + 1] = mergeRow(i, nullptr, nullptr);
+        }
+    });
+    for (size_t i = 0; i < a.rows(); ++i) {
+        rowPtr[i + 1] += rowPtr[i];
+    }
+    c.colIdx().resize(rowPtr[a.rows()]);
+    c.values().resize(rowPtr[a.rows()]);
+    parallelSparseRows(a, [&](size_t first, size_t last) {
+        for (size_t i = first; i < last; ++i) {
+            mergeRow(i, c.colIdx().data() + rowPtr[i], c.values().data() + rowPtr[i]);
+        }
+    });
+    return c;
+}
+
+// Сложение, если хотя бы одна из матриц разреженная. Две разреженные дают разреженную,
+// иначе к копии плотной матрицы добавляются ненулевые элементы разреженной
+MatrixData sparseSum(const MatrixData& mat1, const MatrixData& mat2) {
+    MatrixData result;
+    result.rows = mat1.rows;
+    result.cols = mat1.cols;
+    if (mat1.isSparse && mat2.isSparse) {
+        result.isSparse = true;
+        result.sparse = addSparse(mat1.sparse, mat2.sparse);
+        return result;
+    }
+    const MatrixData& dense = mat1.isSparse ? mat2 : mat1;
+    const MatrixSparse<double>& sparse = mat1.isSparse ? mat1.sparse : mat2.sparse;
+    result.matrix = dense.matrix;
+    double* c = result.matrix.data();
+    parallelSparseRows(sparse, [&](size_t first, size_t last) {
+        for (size_t i = first; i < last; ++i) {
+            for (size_t k = sparse.rowPtr()[i]; k < sparse.rowPtr()[i + 1]; ++k) {
+                c[i * result.cols + sparse.colIdx()[k]] += sparse.values()[k];
+            }
+        }
+    });
+    return result;
+}
+
+// SpMV: y = A * x
+void spmv(const MatrixSparse<double>& a, const double* x, double* y) {
+    parallelSparseRows(a, [&](size_t first, size_t last) {
+        for (size_t i = first; i < last; ++i) {
+            double sum = 0;
+            for (size_t k = a.rowPtr()[i]; k < a.rowPtr()[i + 1]; ++k) {
+                sum += a.values()[k] * x[a.colIdx()[k]];
+            }
+            y[i] = sum;
+        }
+    });
+}
+
+// SpMM: C (m x n) = A (разреженная m x k) * B (плотная k x n). Строка C накапливается
+// как сумма строк B с весами из строки A; внутренний цикл по n векторизуется
+void spmm(const MatrixSparse<double>& a, const double* b, size_t n, double* c) {
+    parallelSparseRows(a, [&](size_t first, size_t last) {
+        for (size_t i = first; i < last; ++i) {
+            double* __restrict row = c + i * n;
+            fill(row, row + n, 0.0);
+            for (size_t k = a.rowPtr()[i]; k < a.rowPtr()[i + 1]; ++k) {
+                const double* __restrict brow = b + size_t(a.colIdx()[k]) * n;
+                double v = a.values()[k];
+                for (size_t j = 0; j < n; ++j) {
+                    row[j] += v * brow[j];
+                }
+            }
+        }
+    });
+}
+
+// Плотная A (m x k) на разреженную B (k x n): строка C собирается из строк B,
+// соответствующих ненулевым элементам строки A
+void densesparse(const double* a, size_t m, size_t k, const MatrixSparse<double>& b, double* c) {
+    size_t n = b.cols();
+    size_t tasks = max<size_t>(1, min(m, parallelWorkers() * 8));
+    parallelTasks(tasks, [&](size_t task, size_t) {
+        for (size_t i = m * task / tasks; i < m * (task + 1) / tasks; ++i) {
+            double* row = c + i * n;
+            fill(row, row + n, 0.0);
+            for (size_t p = 0; p < k; ++p) {
+                double v = a[i * k + p];
+                if (v == 0.0) {
+                    continue;
+                }
+                for (size_t q = b.rowPtr()[p]; q < b.rowPtr()[p + 1]; ++q) {
+                    row[b.colIdx()[q]] += v * b.values()[q];
+                }
+            }
+        }
+    });
+}
+
+// Произведение разреженных матриц (алгоритм Густавсона): строка C накапливается
+// в плотном аккумуляторе, список занятых столбцов позволяет очищать только их
+MatrixSparse<double> spgemm(const MatrixSparse<double>& a, const MatrixSparse<double>& b) {
+    MatrixSparse<double> c(a.rows(), b.cols());
+    vector<double> accumulator(b.cols(), 0.0);
+    vector<char> occupied(b.cols(), 0);
+    vector<unsigned> touched;
+    for (size_t i = 0; i < a.rows(); ++i) {
+        for (size_t k = a.rowPtr()[i]; k < a.rowPtr()[i + 1]; ++k) {
+            unsigned p = a.colIdx()[k];
+            double v = a.values()[k];
+            for (size_t q = b.rowPtr()[p]; q < b.rowPtr()[p + 1]; ++q) {
+                unsigned j = b.colIdx()[q];
+                if (!occupied[j]) {
+                    occupied[j] = 1;
+                    touched.push_back(j);
+                }
+                accumulator[j] += v * b.values()[q];
+            }
+        }
+        sort(touched.begin(), touched.end());
+        for (unsigned j : touched) {
+            c.colIdx().push_back(j);
+            c.values().push_back(accumulator[j]);
+            accumulator[j] = 0.0;
+            occupied[j] = 0;
+        }
+        touched.clear();
+        c.rowPtr()[i + 1] = c.nnz();
+    }
+    return c;
+}
+
+// Ядра out = a + b и out = a - b над непрерывными массивами. При stream результат
+// пишется в обход кэша: для массивов больше кэша это убирает чтение строк результата
+// перед записью и освобождает треть пропускной способности памяти
+typedef void (*ElementwiseKernel)(const double* a, const double* b, double* out, size_t n, bool stream);
+
+struct ElementwiseKernels {
+    ElementwiseKernel add;
+    ElementwiseKernel sub;
+    const char* name;
+};
+
+template<bool Subtract>
+void elementwiseScalar(const double* a, const double* b, double* out, size_t n, bool) {
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = Subtract ? a[i] - b[i] : a[i] + b[i];
+    }
+}
+
+#ifdef TASK3_X86_SIMD
+template<bool Subtract>
+__attribute__((target("avx2")))
+void elementwiseAVX2(const double* a, const double* b, double* out, size_t n, bool stream) {
+    size_t i = 0;
+    // Скалярная голова до выравнивания out на 32 байта
+    for (; i < n && (reinterpret_cast<uintptr_t>(out + i) & 31) != 0; ++i) {
+        out[i] = Subtract ? a[i] - b[i] : a[i] + b[i];
+    }
+    for (; i + 4 <= n; i += 4) {
+        __m256d va = _mm256_loadu_pd(a + i), vb = _mm256_loadu_pd(b + i);
+        __m256d r = Subtract ? _mm256_sub_pd(va, vb) : _mm256_add_pd(va, vb);
+        if (stream) {
+            _mm256_stream_pd(out + i, r);
+        } else {
+            _mm256_store_pd(out + i, r);
+        }
+    }
+    for (; i < n; ++i) {
+        out[i] = Subtract ? a[i] - b[i] : a[i] + b[i];
+    }
+    if (stream) {
+        _mm_sfence();
+    }
+}
+
+template<bool Subtract>
+__attribute__((target("avx512f")))
+void elementwiseAVX512(const double* a, const double* b, double* out, size_t n, bool stream) {
+    size_t i = 0;
+    for (; i < n && (reinterpret_cast<uintptr_t>(out + i) & 63) != 0; ++i) {
+        out[i] = Subtract ? a[i] - b[i] : a[i] + b[i];
+    }
+    for (; i + 8 <= n; i += 8) {
+        __m512d va = _mm512_loadu_pd(a + i), vb = _mm512_loadu_pd(b + i);
+        __m512d r = Subtract ? _mm512_sub_pd(va, vb) : _mm512_add_pd(va, vb);
+        if (stream) {
+            _mm512_stream_pd(out + i, r);
+        } else {
+            _mm512_store_pd(out + i, r);
+        }
+    }
+    for (; i < n; ++i) {
+        out[i] = Subtract ? a[i] - b[i] : a[i] + b[i];
+    }
+    if (stream) {
+        _mm_sfence();
+    }
+}
+#endif
+
+// Выбор ядер во время выполнения по результатам cpuid (выполняется один раз)
+const ElementwiseKernels& elementwiseKernels() {
+    static const ElementwiseKernels kernels = []() {
+#ifdef TASK3_X86_SIMD
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f")) {
+            return ElementwiseKernels{elementwiseAVX512<false>, elementwiseAVX512<true>, "AVX-512"};
+        }
+        if (__builtin_cpu_supports("avx2")) {
+            return ElementwiseKernels{elementwiseAVX2<false>, elementwiseAVX2<true>, "AVX2"};
+        }
+#endif
+        return ElementwiseKernels{elementwiseScalar<false>, elementwiseScalar<true>, "scalar"};
+    }();
+    return kernels;
+}
+
+// Меньшие массивы обрабатываются одним потоком: запуск пула дороже прохода по ним
+const size_t ELEMENTWISE_PARALLEL_MIN = size_t(1) << 16;
+
+// Запись в обход кэша выгодна, когда три массива не помещаются в кэш последнего уровня
+const size_t ELEMENTWISE_STREAM_MIN_BYTES = size_t(32) << 20;
+
+// Поэлементное сложение или вычитание на всех ядрах: каждый поток обрабатывает
+// свой непрерывный диапазон (кратный 8 элементам, чтобы не делить строки кэша)
+void parallelElementwise(bool subtract, const double* a, const double* b, double* out, size_t n) {
+    ElementwiseKernel kernel = subtract ? elementwiseKernels().sub : elementwiseKernels().add;
+    if (n < ELEMENTWISE_PARALLEL_MIN) {
+        kernel(a, b, out, n, false);
+        return;
+    }
+    bool stream = n * sizeof(double) * 3 >= ELEMENTWISE_STREAM_MIN_BYTES;
+    parallelRanges(n, 8, [&](size_t begin, size_t end) { kernel(a + begin, b + begin, out + begin, end - begin, stream); });
+}
+
+// Шаблоны выражений для поэлементных операций над матрицами и векторами.
+// a + b - c * k строит дерево узлов без вычислений, а evaluateInto проходит по
+// памяти один раз: каждый элемент результата считается целиком в регистрах,
+// промежуточные массивы не создаются, цикл векторизуется компилятором
+template<typename E>
+struct ElementwiseExpr {
+    const E& self() const { return static_cast<const E&>(*this); }
+};
+
+// Лист дерева: данные матрицы или вектора
+struct TerminalExpr : ElementwiseExpr<TerminalExpr> {
+    const double* values;
+    size_t count;
+
+    TerminalExpr(const double* values, size_t count) : values(values), count(count) {}
+    double operator[](size_t i) const { return values[i]; }
+    size_t size() const { return count; }
+    bool conforms() const { return true; }
+};
+
+// Число, подставляемое во все элементы (размер 0 означает "любой")
+struct ScalarExpr : ElementwiseExpr<ScalarExpr> {
+    double value;
+
+    explicit ScalarExpr(double value) : value(value) {}
+    double operator[](size_t) const { return value; }
+    size_t size() const { return 0; }
+    bool conforms() const { return true; }
+};
+
+struct AddOp { static double apply(double l, double r) { return l + r; } };
+struct SubOp { static double apply(double l, double r) { return l - r; } };
+struct MulOp { static double apply(double l, double r) { return l * r; } };
+
+template<typename Op, typename L, typename R>
+struct BinaryExpr : ElementwiseExpr<BinaryExpr<Op, L, R>> {
+    L left; // Узлы хранятся по значению: это несколько указателей и чисел
+    R right;
+
+    BinaryExpr(const L& left, const R& right) : left(left), right(right) {}
+    double operator[](size_t i) const { return Op::apply(left[i], right[i]); }
+    size_t size() const { return left.size() != 0 ? left.size() : right.size(); }
+    // Размеры операндов совпадают во всем дереве
+    bool conforms() const {
+        return left.conforms() && right.conforms() &&
+               (left.size() == 0 || right.size() == 0 || left.size() == right.size());
+    }
+};
+
+template<typename L, typename R>
+BinaryExpr<AddOp, L, R> operator+(const ElementwiseExpr<L>& l, const ElementwiseExpr<R>& r) {
+    return BinaryExpr<AddOp, L, R>(l.self(), r.self());
+}
+
+template<typename L, typename R>
+BinaryExpr<SubOp, L, R> operator-(const ElementwiseExpr<L>& l, const ElementwiseExpr<R>& r) {
+    return BinaryExpr<SubOp, L, R>(l.self(), r.self());
+}
+
+template<typename L>
+BinaryExpr<MulOp, L, ScalarExpr> operator*(const ElementwiseExpr<L>& l, double k) {
+    return BinaryExpr<MulOp, L, ScalarExpr>(l.self(), ScalarExpr(k));
+}
+
+template<typename R>
+BinaryExpr<MulOp, ScalarExpr, R> operator*(double k, const ElementwiseExpr<R>& r) {
+    return BinaryExpr<MulOp, ScalarExpr, R>(ScalarExpr(k), r.self());
+}
+
+TerminalExpr asExpr(const MatrixData& m) {
+    return TerminalExpr(m.matrix.data(), size_t(m.rows) * m.cols);
+}
+
+TerminalExpr asExpr(const VectorData& v) {
+    return TerminalExpr(v.values.data(), v.values.size());
+}
+
+// Вычисление выражения в out[0..n) за один проход. false, если размеры не совпадают
+template<typename E>
+bool evaluateInto(const ElementwiseExpr<E>& e, double* __restrict out, size_t n) {
+    const E& x = e.self();
+    if (!x.conforms() || (x.size() != 0 && x.size() != n)) {
+        return false;
+    }
+    // Большие выражения делятся между потоками пула
+    auto range = [&](size_t begin, size_t end) {
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC ivdep
+#endif
+        for (size_t i = begin; i < end; ++i) {
+            out[i] = x[i];
+        }
+    };
+    if (n < ELEMENTWISE_PARALLEL_MIN) {
+        range(0, n);
+    } else {
+        parallelRanges(n, 8, range);
+    }
+    return true;
+}
+
+// Частный случай a + b и a - b над двумя массивами: ядра с явным SIMD
+// и записью результата в обход кэша (parallelElementwise)
+template<typename Op>
+bool evaluateInto(const ElementwiseExpr<BinaryExpr<Op, TerminalExpr, TerminalExpr>>& e, double* out, size_t n) {
+    static_assert(is_same<Op, AddOp>::value || is_same<Op, SubOp>::value, "Ожидалось сложение или вычитание");
+    const BinaryExpr<Op, TerminalExpr, TerminalExpr>& x = e.self();
+    if (!x.conforms() || x.size() != n) {
+        return false;
+    }
+    parallelElementwise(is_same<Op, SubOp>::value, x.left.values, x.right.values, out, n);
+    return true;
+}
+
+// Выражение из строки (--op "a + b - c * 2"). Шаблоны здесь неприменимы, так как
+// дерево известно только во время выполнения, поэтому выражение компилируется
+// в обратную польскую запись и исполняется блоками по FUSED_BLOCK элементов:
+// промежуточные значения живут в маленьких буферах в L1, а по входным массивам
+// и результату выполняется один проход.
+// Грамматика: выражение = слагаемое {(+|-) слагаемое}; слагаемое = множитель {* множитель};
+// множитель = число | a | b | c | (выражение) | -множитель. Умножение допускается только на число
+class FusedExpression {
+public:
+    static constexpr size_t FUSED_BLOCK = 256;
+    static constexpr int MAX_OPERANDS = 3;
+
+    // Разбор строки; при ошибке возвращает false и текст ошибки
+    bool parse(const string& text, string& error) {
+        program.clear();
+        used.assign(MAX_OPERANDS, false);
+        pos = text.c_str();
+        end = pos + text.size();
+        error.clear();
+        bool scalar = false;
+        if (!parseSum(scalar, error)) {
+            return false;
+        }
+        skipSpaces();
+        if (pos != end) {
+            error = string("Ошибка: лишние символы в выражении: ") + pos;
+            return false;
+        }
+        if (scalar) {
+            error = "Ошибка: выражение не содержит операндов";
+            return false;
+        }
+        // Максимальная глубина стека при исполнении
+        maxDepth = 0;
+        size_t depth = 0;
+        for (const Instr& in : program) {
+            depth += (in.kind == Instr::Operand || in.kind == Instr::Constant) ? 1 : (in.kind == Instr::Neg ? 0 : -1);
+            maxDepth = max(maxDepth, depth);
+        }
+        return true;
+    }
+
+    // Используется ли операнд с номером index (a = 0, b = 1, c = 2)
+    bool uses(int index) const { return used[index]; }
+
+    // Вычисление в out[0..n); operands[k] указывает на данные операнда k длины n
+    void evaluate(const double* const* operands, double* out, size_t n) const {
+        if (n < ELEMENTWISE_PARALLEL_MIN) {
+            evaluateRange(operands, out, 0, n);
+        } else {
+            parallelRanges(n, FUSED_BLOCK, [&](size_t begin, size_t end) { evaluateRange(operands, out, begin, end); });
+        }
+    }
+
+private:
+    void evaluateRange(const double* const* operands, double* out, size_t begin, size_t end) const {
+        vector<double> scratch(max<size_t>(maxDepth, 1) * FUSED_BLOCK);
+        vector<Slot> stack(maxDepth);
+        for (size_t start = begin; start < end; start += FUSED_BLOCK) {
+            size_t len = min(FUSED_BLOCK, end - start);
+            size_t depth = 0;
+            for (const Instr& in : program) {
+                if (in.kind == Instr::Operand) {
+                    stack[depth++] = Slot{operands[in.operand] + start, 0.0, false};
+                } else if (in.kind == Instr::Constant) {
+                    stack[depth++] = Slot{nullptr, in.value, true};
+                } else if (in.kind == Instr::Neg) {
+                    Slot& x = stack[depth - 1];
+                    double* dst = scratch.data() + (depth - 1) * FUSED_BLOCK;
+                    for (size_t i = 0; i < len; ++i) {
+                        dst[i] = -x.ptr[i];
+                    }
+                    x.ptr = dst;
+                } else {
+                    Slot r = stack[--depth];
+                    Slot& l = stack[depth - 1];
+                    double* dst = scratch.data() + (depth - 1) * FUSED_BLOCK;
+                    applyBinary(in.kind, l, r, dst, len);
+                    l = Slot{dst, 0.0, false};
+                }
+            }
+            memcpy(out + start, stack[0].ptr, len * sizeof(double));
+        }
+    }
+
+    struct Instr {
+        enum Kind { Operand, Constant, Add, Sub, Mul, Neg } kind;
+        int operand;
+        double value;
+    };
+
+    struct Slot {
+        const double* ptr; // Блок значений (если не число)
+        double scalar;
+        bool isScalar;
+    };
+
+    vector<Instr> program;
+    vector<bool> used;
+    size_t maxDepth = 0;
+    const char* pos = nullptr;
+    const char* end = nullptr;
+
+    static void applyBinary(typename Instr::Kind kind, const Slot& l, const Slot& r, double* dst, size_t len) {
+        if (kind == Instr::Mul) {
+            // Один из множителей всегда число (проверено при разборе)
+            const double* x = l.isScalar ? r.ptr : l.ptr;
+            double k = l.isScalar ? l.scalar : r.scalar;
+            for (size_t i = 0; i < len; ++i) dst[i] = x[i] * k;
+        } else if (l.isScalar || r.isScalar) {
+            double k = l.isScalar ? l.scalar : r.scalar;
+            const double* x = l.isScalar ? r.ptr : l.ptr;
+            double sign = (kind == Instr::Sub && l.isScalar) ? -1.0 : 1.0;
+            double shift = (kind == Instr::Sub && !l.isScalar) ? -k : k;
+            for (size_t i = 0; i < len; ++i) dst[i] = sign * x[i] + shift;
+        } else if (kind == Instr::Add) {
+            for (size_t i = 0; i < len; ++i) dst[i] = l.ptr[i] + r.ptr[i];
+        } else {
+            for (size_t i = 0; i < len; ++i) dst[i] = l.ptr[i] - r.ptr[i];
+        }
+    }
+
+    void skipSpaces() {
+        while (pos < end && (*pos == ' ' || *pos == '\t')) {
+            ++pos;
+        }
+    }
+
+    // Добавление бинарной операции; два числа сворачиваются сразу
+    void emitBinary(typename Instr::Kind kind, bool& scalar, bool rightScalar) {
+        if (scalar && rightScalar) {
+            double r = program.back().value;
+            program.pop_back();
+            double& l = program.back().value;
+            l = kind == Instr::Add ? l + r : (kind == Instr::Sub ? l - r : l * r);
+            return;
+        }
+        program.push_back(Instr{kind, -1, 0.0});
+        scalar = false;
+    }
+
+    bool parseSum(bool& scalar, string& error) {
+        if (!parseProduct(scalar, error)) {
+            return false;
+        }
+        for (skipSpaces(); pos < end && (*pos == '+' || *pos == '-'); skipSpaces()) {
+            typename Instr::Kind kind = *pos++ == '+' ? Instr::Add : Instr::Sub;
+            bool rightScalar = false;
+            if (!parseProduct(rightScalar, error)) {
+                return false;
+            }
+            emitBinary(kind, scalar, rightScalar);
+        }
+        return true;
+    }
+
+    bool parseProduct(bool& scalar, string& error) {
+        if (!parseFactor(scalar, error)) {
+            return false;
+        }
+        for (skipSpaces(); pos < end && *pos == '*'; skipSpaces()) {
+            ++pos;
+            bool rightScalar = false;
+            if (!parseFactor(rightScalar, error)) {
+                return false;
+            }
+            if (!scalar && !rightScalar) {
+                error = "Ошибка: умножение допускается только на число";
+                return false;
+            }
+            emitBinary(Instr::Mul, scalar, rightScalar);
+        }
+        return true;
+    }
+
+    bool parseFactor(bool& scalar, string& error) {
+        skipSpaces();
+        if (pos == end) {
+            error = "Ошибка: неожиданный конец выражения";
+            return false;
+        }
+        if (*pos == '(') {
+            ++pos;
+            if (!parseSum(scalar, error)) {
+                return false;
+            }
+            skipSpaces();
+            if (pos == end || *pos != ')') {
+                error = "Ошибка: нет закрывающей скобки";
+                return false;
+            }
+            ++pos;
+            return true;
+        }
+        if (*pos == '-') {
+            ++pos;
+            if (!parseFactor(scalar, error)) {
+                return false;
+            }
+            if (scalar) {
+                program.back().value = -program.back().value;
+            } else {
+                program.push_back(Instr{Instr::Neg, -1, 0.0});
+            }
+            return true;
+        }
+        if (*pos >= 'a' && *pos < 'a' + MAX_OPERANDS) {
+            int index = *pos++ - 'a';
+            used[index] = true;
+            program.push_back(Instr{Instr::Operand, index, 0.0});
+            scalar = false;
+            return true;
+        }
+        double value = 0;
+        auto res = from_chars(pos, end, value);
+        if (res.ec != errc()) {
+            error = string("Ошибка: неизвестный символ в выражении: ") + pos;
+            return false;
+        }
+        pos = res.ptr;
+        program.push_back(Instr{Instr::Constant, -1, value});
+        scalar = true;
+        return true;
+    }
+};
+
+// Операция --op, заданная выражением над операндами a, b, c.
+// Если среди используемых операндов есть матрицы, результат - матрица, иначе вектор
+bool Calck_expression(const string& text, const VectorData* const* vectors, const MatrixData* const* matrices, CalcResults& calcResults) {
+    FusedExpression expression;
+    string error;
+    if (!expression.parse(text, error)) {
+        LOG_ERROR(error);
+        return false;
+    }
+
+    bool matrixMode = false;
+    for (int k = 0; k < FusedExpression::MAX_OPERANDS; ++k) {
+        matrixMode = matrixMode || (expression.uses(k) && matrices[k]->elements() > 0);
+        if (expression.uses(k) && matrices[k]->isSparse) {
+            LOG_ERROR("Ошибка: выражения поддерживают только плотные матрицы");
+            return false;
+        }
+    }
+
+    const double* operands[FusedExpression::MAX_OPERANDS] = {};
+    size_t n = 0;
+    unsigned rows = 0, cols = 0;
+    for (int k = 0; k < FusedExpression::MAX_OPERANDS; ++k) {
+        if (!expression.uses(k)) {
+            continue;
+        }
+        size_t count = matrixMode ? matrices[k]->elements() : vectors[k]->values.size();
+        if (count == 0) {
+            LOG_ERROR(string("Ошибка: операнд ") + char('a' + k) + " не загружен");
+            return false;
+        }
+        if (n != 0 && (count != n || (matrixMode && (matrices[k]->rows != rows || matrices[k]->cols != cols)))) {
+            LOG_ERROR(matrixMode ? "Ошибка! Размерности матриц не совпадают" : "Ошибка! Размерность векторов не совпадает");
+            return false;
+        }
+        n = count;
+        if (matrixMode) {
+            rows = matrices[k]->rows;
+            cols = matrices[k]->cols;
+        }
+        operands[k] = matrixMode ? matrices[k]->matrix.data() : vectors[k]->values.data();
+    }
+
+    if (matrixMode) {
+        MatrixData result;
+        result.rows = rows;
+        result.cols = cols;
+        result.matrix = MatrixDense<double>(rows, cols);
+        expression.evaluate(operands, result.matrix.data(), n);
+        calcResults.matrixResult = move(result);
+    } else {
+        VectorData result;
+        result.size = n;
+        result.values.resize(n);
+        expression.evaluate(operands, result.values.data(), n);
+        calcResults.result = move(result);
+    }
+    return true;
+}
+
+//Функция для сложения матриц
+MatrixData Calck_mm_sum(const MatrixData& mat1, const MatrixData& mat2) {
+    // Проверка на равенство размерностей
+    if (mat1.rows != mat2.rows || mat1.cols != mat2.cols) {
+        LOG_ERROR("Ошибка! Размерности матриц не совпадают");
+        return MatrixData();
+    }
+    if (mat1.isSparse || mat2.isSparse) {
+        return sparseSum(mat1, mat2);
+    }
+
+    MatrixData result; // Создаем объект для хранения результата сложения матриц
+    result.rows = mat1.rows; // Устанавливаем размер результирующей матрицы
+    result.cols = mat1.cols;
+    result.matrix = MatrixDense<double>(result.rows, result.cols); // Инициализируем матрицу
+
+    // Сложение матриц одним проходом по памяти на всех ядрах
+    evaluateInto(asExpr(mat1) + asExpr(mat2), result.matrix.data(), result.elements());
+
+    return result;
+}
+
+// Функция для сложения двух векторов
+VectorData Calck_vv_sum(const VectorData& vec1, const VectorData& vec2) {
+    // Проверка на равенство размерностей
+    if (vec1.size != vec2.size) {
+        LOG_ERROR("Ошибка! Размерность векторов не совпадает");
+        return VectorData();
+    }
+
+    VectorData result; // Создаем объект для хранения результата сложения векторов
+    result.size = vec1.size; // Устанавливаем размер результирующего вектора равным размеру первого вектора
+    result.values.resize(result.size); // Изменяем размер массива значений результирующего вектора
+
+    // Сложение векторов (resize не обнуляет память, первая запись - в параллельном ядре)
+    evaluateInto(asExpr(vec1) + asExpr(vec2), result.values.data(), result.values.size());
+
+    return result;
+}
+
+//Функция для вычитания векторов
+VectorData Calck_vv_sub(const VectorData& vec1, const VectorData& vec2) {
+    // Проверка на равенство размерностей
+    if (vec1.size != vec2.size) {
+        LOG_ERROR("Ошибка! Размерность векторов не совпадает");
+        return VectorData();
+    }
+
+    VectorData result; // Создаем объект для хранения результата вычитания векторов
+    result.size = vec1.size; // Устанавливаем размер результирующего вектора равным размеру первого вектора
+    result.values.resize(result.size); // Изменяем размер массива значений результирующего вектора
+
+    // Вычитание векторов
+    evaluateInto(asExpr(vec1) - asExpr(vec2), result.values.data(), result.values.size());
+
+    return result;
+}
+
+// Микроядро умножения: C[MR x NR] += Apanel[kc x MR] * Bpanel[kc x NR].
+// Панели упакованы так, что для каждого p подряд лежат MR элементов столбца A
+// и NR элементов строки B; ldc - шаг строк C
+typedef void (*GemmMicroKernel)(size_t kc, const double* a, const double* b, double* c, size_t ldc);
+
+// Параметры блочного умножения для конкретного набора инструкций:
+// MR x NR - блок C в регистрах, KC - глубина панелей (панель B в L1),
+// MC x KC - блок A (в L2), KC x NC - панель B (в L3)
+struct GemmKernel {
+    GemmMicroKernel micro;
+    size_t mr, nr, mc, kc, nc;
+    const char* name;
+};
+
+template<size_t MR, size_t NR>
+void gemmMicroScalar(size_t kc, const double* a, const double* b, double* c, size_t ldc) {
+    double acc[MR][NR] = {};
+    for (size_t p = 0; p < kc; ++p, a += MR, b += NR) {
+        for (size_t i = 0; i < MR; ++i) {
+            for (size_t j = 0; j < NR; ++j) {
+                acc[i][j] += a[i] * b[j];
+            }
+        }
+    }
+    for (size_t i = 0; i < MR; ++i) {
+        for (size_t j = 0; j < NR; ++j) {
+            c[i * ldc + j] += acc[i][j];
+        }
+    }
+}
+
+#ifdef TASK3_X86_SIMD
+// AVX2 + FMA: блок 6x8 - 12 регистров-аккумуляторов, 2 под строку B, 1 под элемент A
+__attribute__((target("avx2,fma")))
+void gemmMicroAVX2(size_t kc, const double* a, const double* b, double* c, size_t ldc) {
+    __m256d acc[6][2];
+#pragma GCC unroll 6
+    for (int i = 0; i < 6; ++i) {
+        acc[i][0] = _mm256_setzero_pd();
+        acc[i][1] = _mm256_setzero_pd();
+    }
+    for (size_t p = 0; p < kc; ++p, a += 6, b += 8) {
+        __m256d b0 = _mm256_load_pd(b), b1 = _mm256_load_pd(b + 4);
+#pragma GCC unroll 6
+        for (int i = 0; i < 6; ++i) {
+            __m256d ai = _mm256_broadcast_sd(a + i);
+            acc[i][0] = _mm256_fmadd_pd(ai, b0, acc[i][0]);
+            acc[i][1] = _mm256_fmadd_pd(ai, b1, acc[i][1]);
+        }
+    }
+#pragma GCC unroll 6
+    for (int i = 0; i < 6; ++i) {
+        double* row = c + i * ldc;
+        _mm256_storeu_pd(row, _mm256_add_pd(_mm256_loadu_pd(row), acc[i][0]));
+        _mm256_storeu_pd(row + 4, _mm256_add_pd(_mm256_loadu_pd(row + 4), acc[i][1]));
+    }
+}
+
+// AVX-512: блок 14x16 - 28 регистров-аккумуляторов из 32
+__attribute__((target("avx512f")))
+void gemmMicroAVX512(size_t kc, const double* a, const double* b, double* c, size_t ldc) {
+    __m512d acc[14][2];
+#pragma GCC unroll 14
+    for (int i = 0; i < 14; ++i) {
+        acc[i][0] = _mm512_setzero_pd();
+        acc[i][1] = _mm512_setzero_pd();
+    }
+    for (size_t p = 0; p < kc; ++p, a += 14, b += 16) {
+        __m512d b0 = _mm512_load_pd(b), b1 = _mm512_load_pd(b + 8);
+#pragma GCC unroll 14
+        for (int i = 0; i < 14; ++i) {
+            __m512d ai = _mm512_set1_pd(a[i]);
+            acc[i][0] = _mm512_fmadd_pd(ai, b0, acc[i][0]);
+            acc[i][1] = _mm512_fmadd_pd(ai, b1, acc[i][1]);
+        }
+    }
+#pragma GCC unroll 14
+    for (int i = 0; i < 14; ++i) {
+        double* row = c + i * ldc;
+        _mm512_storeu_pd(row, _mm512_add_pd(_mm512_loadu_pd(row), acc[i][0]));
+        _mm512_storeu_pd(row + 8, _mm512_add_pd(_mm512_loadu_pd(row + 8), acc[i][1]));
+    }
+}
+#endif
+
+// Выбор микроядра во время выполнения по результатам cpuid (выполняется один раз)
+const GemmKernel& gemmKernel() {
+    static const GemmKernel kernel = []() {
+#ifdef TASK3_X86_SIMD
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f")) {
+            return GemmKernel{gemmMicroAVX512, 14, 16, 14 * 10, 256, 4096, "AVX-512"};
+        }
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+            return GemmKernel{gemmMicroAVX2, 6, 8, 6 * 24, 256, 4096, "AVX2"};
+        }
+#endif
+        return GemmKernel{gemmMicroScalar<4, 4>, 4, 4, 4 * 32, 256, 4096, "scalar"};
+    }();
+    return kernel;
+}
+
+// Упаковка блока A (mc x kc, шаг строк lda) в панели по MR строк; недостающие строки - нули
+void gemmPackA(const GemmKernel& kernel, size_t mc, size_t kc, const double* a, size_t lda, double alpha, double* dst) {
+    for (size_t ir = 0; ir < mc; ir += kernel.mr) {
+        size_t rows = min(kernel.mr, mc - ir);
+        for (size_t p = 0; p < kc; ++p, dst += kernel.mr) {
+            for (size_t i = 0; i < rows; ++i) {
+                dst[i] = alpha * a[(ir + i) * lda + p];
+            }
+            for (size_t i = rows; i < kernel.mr; ++i) {
+                dst[i] = 0.0;
+            }
+        }
+    }
+}
+
+// Упаковка одной панели B (kc x NR столбцов начиная с b, шаг строк ldb); недостающие столбцы - нули
+void gemmPackBPanel(const GemmKernel& kernel, size_t kc, size_t cols, const double* b, size_t ldb, double* dst) {
+    for (size_t p = 0; p < kc; ++p, dst += kernel.nr) {
+        memcpy(dst, b + p * ldb, cols * sizeof(double));
+        for (size_t j = cols; j < kernel.nr; ++j) {
+            dst[j] = 0.0;
+        }
+    }
+}
+
+// Выровненный буфер для упакованных панелей
+struct GemmBuffer {
+    double* data;
+    explicit GemmBuffer(size_t count)
+        : data(static_cast<double*>(::operator new(max<size_t>(count, 1) * sizeof(double), align_val_t(MATRIX_ALIGNMENT)))) {}
+    ~GemmBuffer() { ::operator delete(data, align_val_t(MATRIX_ALIGNMENT)); }
+    GemmBuffer(const GemmBuffer&) = delete;
+    GemmBuffer& operator=(const GemmBuffer&) = delete;
+};
+
+// C (m x n) = alpha * A (m x k) * B (k x n), все матрицы построчные; при accumulate
+// результат прибавляется к C (alpha = -1 дает обновление C -= A * B для разложений).
+// Цикл по панелям B (NC столбцов, KC строк): панель упаковывается параллельно,
+// затем блоки C (MC строк на срез столбцов) раздаются потокам; каждый поток
+// упаковывает свой блок A и проходит его микроядром
+void gemm(size_t m, size_t n, size_t k, const double* a, size_t lda, const double* b, size_t ldb, double* c, size_t ldc,
+          double alpha = 1.0, bool accumulate = false) {
+    const GemmKernel& kernel = gemmKernel();
+    const size_t workers = parallelWorkers();
+    for (size_t i = 0; i < m && !accumulate; ++i) {
+        fill(c + i * ldc, c + i * ldc + n, 0.0);
+    }
+    if (m == 0 || n == 0) {
+        return;
+    }
+    if (k == 0) {
+        return;
+    }
+
+    const size_t ncMax = min(kernel.nc, (n + kernel.nr - 1) / kernel.nr * kernel.nr);
+    GemmBuffer packedB(kernel.kc * ncMax);
+    vector<unique_ptr<GemmBuffer>> packedA(workers);
+    for (auto& buffer : packedA) {
+        buffer.reset(new GemmBuffer(kernel.mc * kernel.kc));
+    }
+
+    for (size_t jc = 0; jc < n; jc += kernel.nc) {
+        size_t nc = min(kernel.nc, n - jc);
+        size_t panels = (nc + kernel.nr - 1) / kernel.nr;
+        for (size_t pc = 0; pc < k; pc += kernel.kc) {
+            size_t kc = min(kernel.kc, k - pc);
+            parallelTasks(panels, [&](size_t panel, size_t) {
+                size_t jr = panel * kernel.nr;
+                gemmPackBPanel(kernel, kc, min(kernel.nr, nc - jr), b + pc * ldb + jc + jr, ldb, packedB.data + panel * kc * kernel.nr);
+            });
+
+            // Если блоков по строкам меньше, чем потоков, столбцы тоже делятся на срезы
+            size_t rowBlocks = (m + kernel.mc - 1) / kernel.mc;
+            size_t colSlices = min(panels, max<size_t>(1, workers / rowBlocks));
+            size_t panelsPerSlice = (panels + colSlices - 1) / colSlices;
+            parallelTasks(rowBlocks * colSlices, [&](size_t task, size_t worker) {
+                size_t ic = (task / colSlices) * kernel.mc;
+                size_t mc = min(kernel.mc, m - ic);
+                size_t firstPanel = (task % colSlices) * panelsPerSlice;
+                size_t lastPanel = min(panels, firstPanel + panelsPerSlice);
+                double* blockA = packedA[worker]->data;
+                gemmPackA(kernel, mc, kc, a + ic * lda + pc, lda, alpha, blockA);
+
+                alignas(64) double edge[16 * 16];
+                for (size_t panel = firstPanel; panel < lastPanel; ++panel) {
+                    size_t jr = panel * kernel.nr;
+                    size_t cols = min(kernel.nr, nc - jr);
+                    const double* panelB = packedB.data + panel * kc * kernel.nr;
+                    for (size_t ir = 0; ir < mc; ir += kernel.mr) {
+                        size_t rows = min(kernel.mr, mc - ir);
+                        double* blockC = c + (ic + ir) * ldc + jc + jr;
+                        const double* panelA = blockA + ir * kc;
+                        if (rows == kernel.mr && cols == kernel.nr) {
+                            kernel.micro(kc, panelA, panelB, blockC, ldc);
+                        } else {
+                            // Краевой блок считается во временный буфер и добавляется частично
+                            fill(edge, edge + kernel.mr * kernel.nr, 0.0);
+                            kernel.micro(kc, panelA, panelB, edge, kernel.nr);
+                            for (size_t i = 0; i < rows; ++i) {
+                                for (size_t j = 0; j < cols; ++j) {
+                                    blockC[i * ldc + j] += edge[i * kernel.nr + j];
+                                }
+                            }
+                        }
+                    }
+                }
+            });
+        }
+    }
+}
+
+//Функция для умножения матриц
+MatrixData Calck_mm_mul(const MatrixData& mat1, const MatrixData& mat2) {
+    // Число столбцов первой матрицы должно совпадать с числом строк второй
+    if (mat1.cols != mat2.rows) {
+        LOG_ERROR("Ошибка! Число столбцов первой матрицы не совпадает с числом строк второй");
+        return MatrixData();
+    }
+
+    MatrixData result;
+    result.rows = mat1.rows;
+    result.cols = mat2.cols;
+    if (mat1.isSparse && mat2.isSparse) {
+        result.isSparse = true;
+        result.sparse = spgemm(mat1.sparse, mat2.sparse);
+        return result;
+    }
+    result.matrix = MatrixDense<double>(result.rows, result.cols);
+    if (mat1.isSparse) {
+        spmm(mat1.sparse, mat2.matrix.data(), mat2.cols, result.matrix.data());
+        return result;
+    }
+    if (mat2.isSparse) {
+        densesparse(mat1.matrix.data(), mat1.rows, mat1.cols, mat2.sparse, result.matrix.data());
+        return result;
+    }
+    gemm(mat1.rows, mat2.cols, mat1.cols, mat1.matrix.data(), mat1.cols, mat2.matrix.data(), mat2.cols,
+         result.matrix.data(), result.cols);
+    return result;
+}
+
+//Функция для умножения матрицы (плотной или разреженной) на вектор
+VectorData Calck_mv_mul(const MatrixData& mat, const VectorData& vec) {
+    if (mat.elements() == 0 || mat.cols != vec.values.size()) {
+        LOG_ERROR("Ошибка! Число столбцов матрицы не совпадает с размерностью вектора");
+        return VectorData();
+    }
+    VectorData result;
+    result.size = mat.rows;
+    result.values.resize(mat.rows);
+    if (mat.isSparse) {
+        spmv(mat.sparse, vec.values.data(), result.values.data());
+    } else {
+        gemm(mat.rows, 1, mat.cols, mat.matrix.data(), mat.cols, vec.values.data(), 1, result.values.data(), 1);
+    }
+    return result;
+}
+
+// Прямое решение плотных систем A X = B. Разложение хранится в объекте и повторно
+// используется для любых правых частей: повторные решения с той же A стоят O(n^2)
+// на столбец вместо O(n^3) на разложение
+enum class FactorizationKind { Auto, LU, Cholesky };
+
+// Диапазон [0, n) делится между потоками, только если работы достаточно
+void solverRanges(size_t n, size_t work, const function<void(size_t, size_t)>& body) {
+    if (work < ELEMENTWISE_PARALLEL_MIN || parallelWorkers() == 1) {
+        body(0, n);
+    } else {
+        parallelRanges(n, 1, body);
+    }
+}
+
+class LinearSolver {
+private:
+    // LU: под диагональю L (единичная диагональ не хранится), на диагонали и выше U.
+    // Холецкий: нижний треугольник L, A = L * L^T; верхний треугольник не используется
+    MatrixDense<double> factors;
+    vector<size_t> pivots; // LU: на шаге j строка j переставлена со строкой pivots[j]
+    FactorizationKind kind = FactorizationKind::LU;
+    size_t n = 0;
+    bool ready = false;
+
+    // U12 = L11^-1 * A12 для единичной нижнетреугольной L11 (строки [k, k + kb)) и
+    // столбцов [col, col + cols): столбцы независимы и делятся между потоками
+    void solveUnitLower(size_t k, size_t kb, size_t col, size_t cols) {
+        double* a = factors.data();
+        solverRanges(cols, cols * kb * kb, [&](size_t begin, size_t end) {
+            for (size_t i = k + 1; i < k + kb; ++i) {
+                double* row = a + i * n + col;
+                for (size_t j = k; j < i; ++j) {
+                    const double l = a[i * n + j];
+                    const double* upper = a + j * n + col;
+                    for (size_t c = begin; c < end; ++c) {
+                        row[c] -= l * upper[c];
+                    }
+                }
+            }
+        });
+    }
+
+    // Рекурсивное LU панели из столбцов [k, k + kb), строки [k, n): левая половина
+    // раскладывается, правая обновляется через треугольное решение и gemm, затем
+    // раскладывается сама. Так построчное хранение не проходит всю высоту панели
+    // на каждом столбце. Строки переставляются целиком, поэтому L слева уже в порядке pivots
+    bool factorPanel(size_t k, size_t kb) {
+        double* a = factors.data();
+        if (kb <= PANEL_LEAF) {
+            for (size_t j = k; j < k + kb; ++j) {
+                size_t p = j;
+                double best = fabs(a[j * n + j]);
+                for (size_t i = j + 1; i < n; ++i) {
+                    if (fabs(a[i * n + j]) > best) {
+                        best = fabs(a[i * n + j]);
+                        p = i;
+                    }
+                }
+                if (best == 0.0) {
+                    return false;
+                }
+                pivots[j] = p;
+                if (p != j) {
+                    swap_ranges(a + j * n, a + (j + 1) * n, a + p * n);
+                }
+                const double inv = 1.0 / a[j * n + j];
+                const double* pivotRow = a + j * n;
+                const size_t panelEnd = k + kb;
+                solverRanges(n - j - 1, (n - j - 1) * (panelEnd - j), [&](size_t begin, size_t end) {
+                    for (size_t i = j + 1 + begin; i < j + 1 + end; ++i) {
+                        double* row = a + i * n;
+                        double l = row[j] *= inv;
+                        for (size_t c = j + 1; c < panelEnd; ++c) {
+                            row[c] -= l * pivotRow[c];
+                        }
+                    }
+                });
+            }
+            return true;
+        }
+        size_t left = kb / 2, right = kb - left;
+        if (!factorPanel(k, left)) {
+            return false;
+        }
+        solveUnitLower(k, left, k + left, right);
+        gemm(n - k - left, right, left, a + (k + left) * n + k, n, a + k * n + k + left, n,
+             a + (k + left) * n + k + left, n, -1.0, true);
+        return factorPanel(k + left, right);
+    }
+
+    // Блочное LU с частичным выбором главного элемента (правосторонний вариант):
+    // панель BLOCK столбцов раскладывается рекурсивно, затем блок U12 находится
+    // треугольным решением, а основная работа - обновление A22 -= L21 * U12 - идет через gemm
+    bool factorLU() {
+        double* a = factors.data();
+        pivots.assign(n, 0);
+        for (size_t k = 0; k < n; k += BLOCK) {
+            size_t kb = min(BLOCK, n - k);
+            if (!factorPanel(k, kb)) {
+                return false;
+            }
+            size_t rest = n - k - kb;
+            if (rest > 0) {
+                solveUnitLower(k, kb, k + kb, rest);
+                gemm(rest, rest, kb, a + (k + kb) * n + k, n, a + k * n + k + kb, n, a + (k + kb) * n + k + kb, n, -1.0, true);
+            }
+        }
+        return true;
+    }
+
+    // Блочное разложение Холецкого: диагональный блок раскладывается напрямую,
+    // L21 = A21 * L11^-T построчно в потоках, обновление A22 -= L21 * L21^T через gemm
+    // только для нижнего треугольника (по полосам строк)
+    bool factorCholesky() {
+        double* a = factors.data();
+        vector<double, AlignedAllocator<double>> transposed;
+        for (size_t k = 0; k < n; k += BLOCK) {
+            size_t kb = min(BLOCK, n - k);
+            for (size_t j = k; j < k + kb; ++j) {
+                double d = a[j * n + j];
+                for (size_t p = k; p < j; ++p) {
+                    d -= a[j * n + p] * a[j * n + p];
+                }
+                if (!(d > 0.0)) {
+                    return false; // Матрица не положительно определена
+                }
+                a[j * n + j] = sqrt(d);
+                for (size_t i = j + 1; i < k + kb; ++i) {
+                    double s = a[i * n + j];
+                    for (size_t p = k; p < j; ++p) {
+                        s -= a[i * n + p] * a[j * n + p];
+                    }
+                    a[i * n + j] = s / a[j * n + j];
+                }
+            }
+            size_t rest = n - k - kb;
+            if (rest == 0) {
+                continue;
+            }
+            solverRanges(rest, rest * kb * kb, [&](size_t begin, size_t end) {
+                for (size_t i = k + kb + begin; i < k + kb + end; ++i) {
+                    double* row = a + i * n;
+                    for (size_t j = k; j < k + kb; ++j) {
+                        double s = row[j];
+                        for (size_t p = k; p < j; ++p) {
+                            s -= row[p] * a[j * n + p];
+                        }
+                        row[j] = s / a[j * n + j];
+                    }
+                }
+            });
+            // L21^T копируется в построчный буфер kb x rest - второй операнд gemm
+            transposed.resize(kb * rest);
+            for (size_t i = 0; i < rest; ++i) {
+                for (size_t p = 0; p < kb; ++p) {
+                    transposed[p * rest + i] = a[(k + kb + i) * n + k + p];
+                }
+            }
+            for (size_t r = 0; r < rest; r += BLOCK) {
+                size_t rb = min(BLOCK, rest - r);
+                gemm(rb, r + rb, kb, a + (k + kb + r) * n + k, n, transposed.data(), rest,
+                     a + (k + kb + r) * n + k + kb, n, -1.0, true);
+            }
+        }
+        return true;
+    }
+
+    // Симметричность проверяется перед попыткой разложения Холецкого
+    static bool isSymmetric(const MatrixDense<double>& a, size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            for (size_t j = 0; j < i; ++j) {
+                double x = a.getElement(i, j), y = a.getElement(j, i);
+                if (fabs(x - y) > 1e-12 * max(fabs(x), fabs(y))) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+public:
+    static constexpr size_t BLOCK = 128;
+    static constexpr size_t PANEL_LEAF = 8; // Ширина панели, раскладываемой по столбцам
+
+    LinearSolver() : factors(0, 0) {}
+
+    // Разложение квадратной плотной матрицы. Auto: для симметричной матрицы сначала
+    // пробуется Холецкий (вдвое меньше операций), при неудаче - LU.
+    // Возвращает false для вырожденной матрицы (или не SPD при явном Cholesky)
+    bool factor(const MatrixData& a, FactorizationKind requested = FactorizationKind::Auto) {
+        ready = false;
+        if (a.isSparse || a.rows != a.cols || a.elements() == 0) {
+            LOG_ERROR("Ошибка: для разложения нужна квадратная плотная матрица");
+            return false;
+        }
+        n = a.rows;
+        if (requested != FactorizationKind::LU && (requested == FactorizationKind::Cholesky || isSymmetric(a.matrix, n))) {
+            factors = a.matrix;
+            kind = FactorizationKind::Cholesky;
+            ready = factorCholesky();
+            if (ready || requested == FactorizationKind::Cholesky) {
+                return ready;
+            }
+            LOG_INFO("Матрица симметрична, но не положительно определена: используется LU");
+        }
+        factors = a.matrix;
+        kind = FactorizationKind::LU;
+        ready = factorLU();
+        return ready;
+    }
+
+    // Решение для nrhs правых частей, записанных построчно в b (n x nrhs); результат
+    // записывается на место b. Оба хода блочные: вклад уже найденных блоков вычитается
+    // через gemm, внутри диагонального блока столбцы правых частей делятся между потоками
+    bool solve(double* b, size_t nrhs) const {
+        if (!ready) {
+            return false;
+        }
+        const double* f = factors.data();
+        const bool lu = kind == FactorizationKind::LU;
+        if (lu) {
+            for (size_t j = 0; j < n; ++j) {
+                if (pivots[j] != j) {
+                    swap_ranges(b + j * nrhs, b + (j + 1) * nrhs, b + pivots[j] * nrhs);
+                }
+            }
+        }
+
+        // Прямой ход: L * Y = B
+        for (size_t k = 0; k < n; k += BLOCK) {
+            size_t kb = min(BLOCK, n - k);
+            gemm(kb, nrhs, k, f + k * n, n, b, nrhs, b + k * nrhs, nrhs, -1.0, true);
+            solverRanges(nrhs, nrhs * kb * kb, [&](size_t begin, size_t end) {
+                for (size_t i = k; i < k + kb; ++i) {
+                    double* row = b + i * nrhs;
+                    for (size_t j = k; j < i; ++j) {
+                        const double l = f[i * n + j];
+                        const double* solved = b + j * nrhs;
+                        for (size_t c = begin; c < end; ++c) {
+                            row[c] -= l * solved[c];
+                        }
+                    }
+                    if (!lu) {
+                        const double inv = 1.0 / f[i * n + i];
+                        for (size_t c = begin; c < end; ++c) {
+                            row[c] *= inv;
+                        }
+                    }
+                }
+            });
+        }
+
+        // Обратный ход: U * X = Y (LU) или L^T * X = Y (Холецкий; нужный блок L^T
+        // копируется в построчный буфер)
+        vector<double, AlignedAllocator<double>> transposed;
+        for (size_t k = (n - 1) / BLOCK * BLOCK;; k -= BLOCK) {
+            size_t kb = min(BLOCK, n - k), rest = n - k - kb;
+            if (lu) {
+                gemm(kb, nrhs, rest, f + k * n + k + kb, n, b + (k + kb) * nrhs, nrhs, b + k * nrhs, nrhs, -1.0, true);
+            } else if (rest > 0) {
+                transposed.resize(kb * rest);
+                for (size_t i = 0; i < rest; ++i) {
+                    for (size_t p = 0; p < kb; ++p) {
+                        transposed[p * rest + i] = f[(k + kb + i) * n + k + p];
+                    }
+                }
+                gemm(kb, nrhs, rest, transposed.data(), rest, b + (k + kb) * nrhs, nrhs, b + k * nrhs, nrhs, -1.0, true);
+            }
+            solverRanges(nrhs, nrhs * kb * kb, [&](size_t begin, size_t end) {
+                for (size_t i = k + kb; i-- > k;) {
+                    double* row = b + i * nrhs;
+                    const double inv = 1.0 / f[i * n + i];
+                    if (lu) {
+                        for (size_t j = i + 1; j < k + kb; ++j) {
+                            const double u = f[i * n + j];
+                            const double* solved = b + j * nrhs;
+                            for (size_t c = begin; c < end; ++c) {
+                                row[c] -= u * solved[c];
+                            }
+                        }
+                        for (size_t c = begin; c < end; ++c) {
+                            row[c] *= inv;
+                        }
+                    } else {
+                        // Строка i матрицы L - это столбец i матрицы L^T: найденный x_i
+                        // сразу вычитается из предыдущих уравнений блока
+                        for (size_t c = begin; c < end; ++c) {
+                            row[c] *= inv;
+                        }
+                        for (size_t j = k; j < i; ++j) {
+                            const double l = f[i * n + j];
+                            double* pending = b + j * nrhs;
+                            for (size_t c = begin; c < end; ++c) {
+                                pending[c] -= l * row[c];
+                            }
+                        }
+                    }
+                }
+            });
+            if (k == 0) {
+                break;
+            }
+        }
+        return true;
+    }
+
+    bool isReady() const { return ready; }
+    size_t size() const { return n; }
+    FactorizationKind type() const { return kind; }
+};
+
+//Функция для решения системы A X = B: правая часть - вектор или матрица (несколько столбцов)
+bool Calck_solve(const LinearSolver& solver, const MatrixData& rhsMatrix, const VectorData& rhsVector, CalcResults& out) {
+    if (rhsMatrix.elements() > 0) {
+        out.matrixResult = MatrixData();
+        if (!solver.isReady() || rhsMatrix.isSparse || rhsMatrix.rows != solver.size()) {
+            LOG_ERROR("Ошибка! Матрица системы вырождена или правая часть не совпадает с ней по числу строк");
+            return false;
+        }
+        out.matrixResult.rows = rhsMatrix.rows;
+        out.matrixResult.cols = rhsMatrix.cols;
+        out.matrixResult.matrix = rhsMatrix.matrix;
+        return solver.solve(out.matrixResult.matrix.data(), rhsMatrix.cols);
+    }
+    if (!solver.isReady() || rhsVector.values.size() != solver.size()) {
+        LOG_ERROR("Ошибка! Матрица системы вырождена или размерность правой части не совпадает с ней");
+        out.result = VectorData();
+        return false;
+    }
+    out.result = rhsVector;
+    return solver.solve(out.result.values.data(), 1);
+}
+
+// Итерационные (крыловские) методы для больших разреженных систем, которые не
+// помещаются в плотный решатель. Методам нужно только умножение A на вектор, поэтому
+// матрица задается оператором и может вообще не храниться (matrix-free)
+class LinearOperator {
+public:
+    virtual ~LinearOperator() {}
+    virtual size_t size() const = 0;
+    virtual void apply(const double* x, double* y) const = 0; // y = A x
+};
+
+// Оператор разреженной матрицы CSR: многопоточное SpMV
+class SparseOperator : public LinearOperator {
+    const MatrixSparse<double>& a;
+
+public:
+    explicit SparseOperator(const MatrixSparse<double>& matrix) : a(matrix) {}
+    size_t size() const override { return a.rows(); }
+    void apply(const double* x, double* y) const override { spmv(a, x, y); }
+};
+
+// Оператор плотной матрицы: умножение на вектор через gemm
+class DenseOperator : public LinearOperator {
+    const MatrixDense<double>& a;
+    size_t n;
+
+public:
+    DenseOperator(const MatrixDense<double>& matrix, size_t size) : a(matrix), n(size) {}
+    size_t size() const override { return n; }
+    void apply(const double* x, double* y) const override { gemm(n, 1, n, a.data(), n, x, 1, y, 1); }
+};
+
+// Предобусловливатель: z = M^-1 r, где M - легко обращаемое приближение A
+class Preconditioner {
+public:
+    virtual ~Preconditioner() {}
+    virtual void apply(const double* r, double* z) const = 0;
+};
+
+class IdentityPreconditioner : public Preconditioner {
+    size_t n;
+
+public:
+    explicit IdentityPreconditioner(size_t size) : n(size) {}
+    void apply(const double* r, double* z) const override { copy(r, r + n, z); }
+};
+
+// Якоби: M = diag(A). Нулевой диагональный элемент заменяется единицей
+class JacobiPreconditioner : public Preconditioner {
+    vector<double> inverse;
+
+public:
+    explicit JacobiPreconditioner(const MatrixData& a) : inverse(a.rows, 1.0) {
+        for (size_t i = 0; i < a.rows; ++i) {
+            double d = 0;
+            if (a.isSparse) {
+                const vector<unsigned>& col = a.sparse.colIdx();
+                auto first = col.begin() + a.sparse.rowPtr()[i], last = col.begin() + a.sparse.rowPtr()[i + 1];
+                auto it = lower_bound(first, last, unsigned(i));
+                if (it != last && *it == i) {
+                    d = a.sparse.values()[it - col.begin()];
+                }
+            } else {
+                d = a.matrix.getElement(i, i);
+            }
+            if (d != 0.0) {
+                inverse[i] = 1.0 / d;
+            }
+        }
+    }
+
+    void apply(const double* r, double* z) const override {
+        solverRanges(inverse.size(), inverse.size(), [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                z[i] = inverse[i] * r[i];
+            }
+        });
+    }
+};
+
+// Неполное LU без заполнения: L и U имеют тот же портрет, что и A (CSR), поэтому
+// памяти нужно столько же. Треугольные решения последовательны по строкам
+class ILU0Preconditioner : public Preconditioner {
+    MatrixSparse<double> lu;
+    vector<size_t> diagonal; // Позиция диагонального элемента в строке
+    bool ok = true;
+
+public:
+    explicit ILU0Preconditioner(const MatrixSparse<double>& a) : lu(a), diagonal(a.rows()) {
+        const size_t n = a.rows();
+        const vector<size_t>& rowPtr = lu.rowPtr();
+        const vector<unsigned>& col = lu.colIdx();
+        vector<double>& value = lu.values();
+        const size_t none = numeric_limits<size_t>::max();
+        vector<size_t> position(a.cols(), none); // Столбец -> позиция в текущей строке
+        for (size_t i = 0; i < n && ok; ++i) {
+            diagonal[i] = none;
+            for (size_t k = rowPtr[i]; k < rowPtr[i + 1]; ++k) {
+                position[col[k]] = k;
+                if (col[k] == i) {
+                    diagonal[i] = k;
+                }
+            }
+            // Исключение: строка i обновляется строками c < i, которые уже разложены
+            for (size_t k = rowPtr[i]; k < rowPtr[i + 1] && col[k] < i; ++k) {
+                size_t c = col[k];
+                double l = value[k] /= value[diagonal[c]];
+                for (size_t q = diagonal[c] + 1; q < rowPtr[c + 1]; ++q) {
+                    if (position[col[q]] != none) {
+                        value[position[col[q]]] -= l * value[q];
+                    }
+                }
+            }
+            ok = diagonal[i] != none && value[diagonal[i]] != 0.0;
+            for (size_t k = rowPtr[i]; k < rowPtr[i + 1]; ++k) {
+                position[col[k]] = none;
+            }
+        }
+        if (!ok) {
+            LOG_ERROR("Ошибка: ILU(0) невозможно - нулевой или отсутствующий диагональный элемент");
+        }
+    }
+
+    bool isValid() const { return ok; }
+
+    void apply(const double* r, double* z) const override {
+        const size_t n = lu.rows();
+        const vector<size_t>& rowPtr = lu.rowPtr();
+        const vector<unsigned>& col = lu.colIdx();
+        const vector<double>& value = lu.values();
+        for (size_t i = 0; i < n; ++i) {
+            double s = r[i];
+            for (size_t k = rowPtr[i]; k < diagonal[i]; ++k) {
+                s -= value[k] * z[col[k]];
+            }
+            z[i] = s;
+        }
+        for (size_t i = n; i-- > 0;) {
+            double s = z[i];
+            for (size_t k = diagonal[i] + 1; k < rowPtr[i + 1]; ++k) {
+                s -= value[k] * z[col[k]];
+            }
+            z[i] = s / value[diagonal[i]];
+        }
+    }
+};
+
+// Векторные ядра итерационных методов. Скалярное произведение делится на фиксированные
+// диапазоны по числу потоков и суммируется в порядке диапазонов, поэтому результат
+// (и число итераций) не меняется от запуска к запуску
+double krylovDot(const double* a, const double* b, size_t n) {
+    const size_t tasks = n < ELEMENTWISE_PARALLEL_MIN ? 1 : parallelWorkers();
+    vector<double> partial(tasks, 0.0);
+    auto body = [&](size_t task, size_t) {
+        size_t begin = n * task / tasks, end = n * (task + 1) / tasks;
+        double s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+        size_t i = begin;
+        for (; i + 4 <= end; i += 4) {
+            s0 += a[i] * b[i];
+            s1 += a[i + 1] * b[i + 1];
+            s2 += a[i + 2] * b[i + 2];
+            s3 += a[i + 3] * b[i + 3];
+        }
+        for (; i < end; ++i) {
+            s0 += a[i] * b[i];
+        }
+        partial[task] = (s0 + s1) + (s2 + s3);
+    };
+    if (tasks == 1) {
+        body(0, 0);
+    } else {
+        parallelTasks(tasks, body);
+    }
+    double sum = 0;
+    for (double part : partial) {
+        sum += part;
+    }
+    return sum;
+}
+
+double krylovNorm(const double* a, size_t n) {
+    return sqrt(krylovDot(a, a, n));
+}
+
+// y += alpha * x
+void krylovAxpy(double alpha, const double* x, double* y, size_t n) {
+    solverRanges(n, n, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            y[i] += alpha * x[i];
+        }
+    });
+}
+
+// y = x + beta * y
+void krylovXpay(const double* x, double beta, double* y, size_t n) {
+    solverRanges(n, n, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            y[i] = x[i] + beta * y[i];
+        }
+    });
+}
+
+enum class IterativeMethod { CG, BiCGStab, GMRES };
+enum class PreconditionerKind { None, Jacobi, ILU0 };
+
+struct IterativeOptions {
+    double tolerance = 1e-8;     // По относительной невязке |b - A x| / |b|
+    size_t maxIterations = 10000;
+    size_t restart = 30;         // Размер базиса GMRES до перезапуска
+};
+
+// Телеметрия сходимости: residuals[k] - относительная невязка после k итераций
+struct IterativeStats {
+    bool converged = false;
+    size_t iterations = 0;
+    vector<double> residuals;
+    double seconds = 0;
+
+    double secondsPerIteration() const { return iterations > 0 ? seconds / iterations : 0.0; }
+};
+
+// Запись невязки очередной итерации; true, если точность достигнута
+bool krylovRecord(IterativeStats& stats, double residual, const IterativeOptions& options) {
+    stats.residuals.push_back(residual);
+    LOG_DEBUG("Итерация " + to_string(stats.residuals.size() - 1) + ", невязка " + to_string(residual));
+    stats.converged = residual <= options.tolerance;
+    return stats.converged;
+}
+
+typedef vector<double, AlignedAllocator<double>> KrylovVector;
+
+// Метод сопряженных градиентов с предобусловливанием (только для SPD матриц)
+void solveCG(const LinearOperator& a, const Preconditioner& m, const double* b, double* x,
+             const IterativeOptions& options, IterativeStats& stats, double normB) {
+    const size_t n = a.size();
+    KrylovVector r(n), z(n), p(n), q(n);
+    a.apply(x, q.data());
+    for (size_t i = 0; i < n; ++i) {
+        r[i] = b[i] - q[i];
+    }
+    if (krylovRecord(stats, krylovNorm(r.data(), n) / normB, options)) {
+        return;
+    }
+    m.apply(r.data(), z.data());
+    p = z;
+    double rz = krylovDot(r.data(), z.data(), n);
+    while (stats.iterations < options.maxIterations) {
+        a.apply(p.data(), q.data());
+        double alpha = rz / krylovDot(p.data(), q.data(), n);
+        krylovAxpy(alpha, p.data(), x, n);
+        krylovAxpy(-alpha, q.data(), r.data(), n);
+        ++stats.iterations;
+        if (krylovRecord(stats, krylovNorm(r.data(), n) / normB, options)) {
+            return;
+        }
+        m.apply(r.data(), z.data());
+        double rzNext = krylovDot(r.data(), z.data(), n);
+        krylovXpay(z.data(), rzNext / rz, p.data(), n);
+        rz = rzNext;
+    }
+}
+
+// BiCGSTAB с правым предобусловливанием (для несимметричных матриц)
+void solveBiCGStab(const LinearOperator& a, const Preconditioner& m, const double* b, double* x,
+                   const IterativeOptions& options, IterativeStats& stats, double normB) {
+    const size_t n = a.size();
+    KrylovVector r(n), shadow(n), p(n, 0.0), v(n, 0.0), s(n), t(n), preconditioned(n);
+    a.apply(x, t.data());
+    for (size_t i = 0; i < n; ++i) {
+        r[i] = b[i] - t[i];
+    }
+    if (krylovRecord(stats, krylovNorm(r.data(), n) / normB, options)) {
+        return;
+    }
+    shadow = r;
+    double rho = 1, alpha = 1, omega = 1;
+    while (stats.iterations < options.maxIterations) {
+        double rhoNext = krylovDot(shadow.data(), r.data(), n);
+        if (rhoNext == 0.0) {
+            LOG_WARNING("BiCGSTAB: вырождение (rho = 0)");
+            return;
+        }
+        double beta = (rhoNext / rho) * (alpha / omega);
+        rho = rhoNext;
+        solverRanges(n, n, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                p[i] = r[i] + beta * (p[i] - omega * v[i]);
+            }
+        });
+        m.apply(p.data(), preconditioned.data());
+        a.apply(preconditioned.data(), v.data());
+        alpha = rho / krylovDot(shadow.data(), v.data(), n);
+        krylovAxpy(alpha, preconditioned.data(), x, n);
+        s = r;
+        krylovAxpy(-alpha, v.data(), s.data(), n);
+        ++stats.iterations;
+        double sNorm = krylovNorm(s.data(), n) / normB;
+        if (sNorm <= options.tolerance) {
+            krylovRecord(stats, sNorm, options);
+            return;
+        }
+        m.apply(s.data(), preconditioned.data());
+        a.apply(preconditioned.data(), t.data());
+        omega = krylovDot(t.data(), s.data(), n) / krylovDot(t.data(), t.data(), n);
+        krylovAxpy(omega, preconditioned.data(), x, n);
+        r = s;
+        krylovAxpy(-omega, t.data(), r.data(), n);
+        if (krylovRecord(stats, krylovNorm(r.data(), n) / normB, options)) {
+            return;
+        }
+        if (omega == 0.0) {
+            LOG_WARNING("BiCGSTAB: вырождение (omega = 0)");
+            return;
+        }
+    }
+}
+
+// GMRES с перезапуском через restart итераций и правым предобусловливанием:
+// ортогонализация Грама-Шмидта (модифицированная), наименьшие квадраты - вращениями Гивенса
+void solveGMRES(const LinearOperator& a, const Preconditioner& m, const double* b, double* x,
+                const IterativeOptions& options, IterativeStats& stats, double normB) {
+    const size_t n = a.size();
+    const size_t restart = max<size_t>(1, options.restart);
+    vector<KrylovVector> basis(restart + 1, KrylovVector(n));
+    vector<double> h((restart + 1) * restart), cs(restart), sn(restart), g(restart + 1);
+    KrylovVector w(n), z(n);
+    bool first = true;
+    while (true) {
+        a.apply(x, w.data());
+        for (size_t i = 0; i < n; ++i) {
+            basis[0][i] = b[i] - w[i];
+        }
+        double beta = krylovNorm(basis[0].data(), n);
+        if (first) {
+            first = false;
+            if (krylovRecord(stats, beta / normB, options)) {
+                return;
+            }
+        }
+        if (stats.converged || stats.iterations >= options.maxIterations || beta == 0.0) {
+            return;
+        }
+        for (size_t i = 0; i < n; ++i) {
+            basis[0][i] /= beta;
+        }
+        fill(g.begin(), g.end(), 0.0);
+        g[0] = beta;
+
+        size_t k = 0;
+        while (k < restart && stats.iterations < options.maxIterations) {
+            m.apply(basis[k].data(), z.data());
+            a.apply(z.data(), w.data());
+            for (size_t i = 0; i <= k; ++i) {
+                double hik = krylovDot(w.data(), basis[i].data(), n);
+                h[i * restart + k] = hik;
+                krylovAxpy(-hik, basis[i].data(), w.data(), n);
+            }
+            double next = krylovNorm(w.data(), n);
+            for (size_t i = 0; i < k; ++i) {
+                double upper = h[i * restart + k], lower = h[(i + 1) * restart + k];
+                h[i * restart + k] = cs[i] * upper + sn[i] * lower;
+                h[(i + 1) * restart + k] = -sn[i] * upper + cs[i] * lower;
+            }
+            double diag = h[k * restart + k], radius = hypot(diag, next);
+            cs[k] = diag / radius;
+            sn[k] = next / radius;
+            h[k * restart + k] = radius;
+            g[k + 1] = -sn[k] * g[k];
+            g[k] *= cs[k];
+            ++k;
+            ++stats.iterations;
+            bool done = krylovRecord(stats, fabs(g[k]) / normB, options);
+            if (done || next == 0.0) {
+                break;
+            }
+            for (size_t i = 0; i < n; ++i) {
+                basis[k][i] = w[i] / next;
+            }
+        }
+
+        // x += M^-1 (V y), где H y = g - верхнетреугольная система размера k
+        for (size_t i = k; i-- > 0;) {
+            for (size_t j = i + 1; j < k; ++j) {
+                g[i] -= h[i * restart + j] * g[j];
+            }
+            g[i] /= h[i * restart + i];
+        }
+        fill(w.begin(), w.end(), 0.0);
+        for (size_t i = 0; i < k; ++i) {
+            krylovAxpy(g[i], basis[i].data(), w.data(), n);
+        }
+        m.apply(w.data(), z.data());
+        krylovAxpy(1.0, z.data(), x, n);
+    }
+}
+
+// Итерационное решение A x = b; x содержит начальное приближение и результат
+IterativeStats solveIterative(IterativeMethod method, const LinearOperator& a, const Preconditioner& m,
+                              const double* b, double* x, const IterativeOptions& options) {
+    IterativeStats stats;
+    const size_t n = a.size();
+    auto t0 = chrono::high_resolution_clock::now();
+    double normB = krylovNorm(b, n);
+    if (normB == 0.0) {
+        fill(x, x + n, 0.0);
+        stats.converged = true;
+        stats.residuals.push_back(0.0);
+        return stats;
+    }
+    if (method == IterativeMethod::CG) {
+        solveCG(a, m, b, x, options, stats, normB);
+    } else if (method == IterativeMethod::BiCGStab) {
+        solveBiCGStab(a, m, b, x, options, stats, normB);
+    } else {
+        solveGMRES(a, m, b, x, options, stats, normB);
+    }
+    stats.seconds = chrono::duration<double>(chrono::high_resolution_clock::now() - t0).count();
+    return stats;
+}
+
+const char* iterativeMethodName(IterativeMethod method) {
+    return method == IterativeMethod::CG ? "CG" : method == IterativeMethod::BiCGStab ? "BiCGSTAB" : "GMRES";
+}
+
+//Функция для итерационного решения системы A X = B (A плотная или разреженная);
+//столбцы матричной правой части решаются по очереди с одним предобусловливателем
+bool Calck_solve_iterative(const MatrixData& a, IterativeMethod method, PreconditionerKind precondKind,
+                           const IterativeOptions& options, const MatrixData& rhsMatrix, const VectorData& rhsVector,
+                           CalcResults& out) {
+    const bool matrixRhs = rhsMatrix.elements() > 0;
+    const size_t n = a.rows;
+    if (matrixRhs) {
+        out.matrixResult = MatrixData();
+    }
+    if (a.rows != a.cols || a.elements() == 0 ||
+        (matrixRhs ? rhsMatrix.rows != n : rhsVector.values.size() != n)) {
+        LOG_ERROR("Ошибка! Матрица системы не квадратная или не совпадает с правой частью по размерности");
+        if (!matrixRhs) {
+            out.result = VectorData();
+        }
+        return false;
+    }
+    if (matrixRhs && rhsMatrix.isSparse) {
+        LOG_ERROR("Ошибка! Правая часть итерационного решения должна быть плотной матрицей");
+        return false;
+    }
+    unique_ptr<LinearOperator> op;
+    if (a.isSparse) {
+        op.reset(new SparseOperator(a.sparse));
+    } else {
+        op.reset(new DenseOperator(a.matrix, n));
+    }
+    unique_ptr<Preconditioner> precond;
+    if (precondKind == PreconditionerKind::ILU0 && a.isSparse) {
+        ILU0Preconditioner* ilu = new ILU0Preconditioner(a.sparse);
+        precond.reset(ilu);
+        if (!ilu->isValid()) {
+            precondKind = PreconditionerKind::Jacobi;
+        }
+    } else if (precondKind == PreconditionerKind::ILU0) {
+        LOG_WARNING("ILU(0) строится только для разреженной матрицы, используется Якоби");
+        precondKind = PreconditionerKind::Jacobi;
+    }
+    if (precondKind == PreconditionerKind::Jacobi) {
+        precond.reset(new JacobiPreconditioner(a));
+    } else if (precondKind == PreconditionerKind::None) {
+        precond.reset(new IdentityPreconditioner(n));
+    }
+
+    const size_t columns = matrixRhs ? rhsMatrix.cols : 1;
+    KrylovVector b(n), x(n);
+    bool converged = true;
+    if (matrixRhs) {
+        out.matrixResult.rows = rhsMatrix.rows;
+        out.matrixResult.cols = rhsMatrix.cols;
+        out.matrixResult.matrix = MatrixDense<double>(rhsMatrix.rows, rhsMatrix.cols);
+    } else {
+        out.result = rhsVector;
+    }
+    for (size_t c = 0; c < columns; ++c) {
+        for (size_t i = 0; i < n; ++i) {
+            b[i] = matrixRhs ? rhsMatrix.matrix.getElement(i, c) : rhsVector.values[i];
+        }
+        fill(x.begin(), x.end(), 0.0);
+        IterativeStats stats = solveIterative(method, *op, *precond, b.data(), x.data(), options);
+        ostringstream message;
+        message << iterativeMethodName(method) << (stats.converged ? ": сошелся за " : ": не сошелся за ")
+                << stats.iterations << " итераций, невязка " << stats.residuals.back() << ", "
+                << stats.secondsPerIteration() * 1e3 << " мс на итерацию";
+        LOG_AT(stats.converged ? LogLevel::Info : LogLevel::Warning, message.str());
+        converged = converged && stats.converged;
+        for (size_t i = 0; i < n; ++i) {
+            (matrixRhs ? out.matrixResult.matrix.getElement(i, c) : out.result.values[i]) = x[i];
+        }
+    }
+    return converged;
+}
+
+// Выходной файл с расширением .mtxb записывается в бинарном формате
+bool isBinaryMatrixPath(const string& path) {
+    const string ext = ".mtxb";
+    return path.size() >= ext.size() && path.compare(path.size() - ext.size(), ext.size(), ext) == 0;
+}
+
+// Выходной файл с расширением .gz записывается сжатым (gzip)
+bool isCompressedPath(const string& path) {
+    const string ext = ".gz";
+    return path.size() >= ext.size() && path.compare(path.size() - ext.size(), ext.size(), ext) == 0;
+}
+
+// Приемник текстового вывода: обычный файл или gzip. Данные передаются большими блоками.
+// Без дозаписи вывод идет во временный файл, который при закрытии заменяет path
+class ExportSink {
+private:
+    ofstream file;
+    string target;     // Заменяемый файл (пусто при дозаписи)
+    string temporary;  // Временный файл, в который идет запись
+#ifdef TASK3_WITH_ZLIB
+    gzFile compressed = nullptr;
+#endif
+    bool ok = false;
+
+public:
+    ExportSink(const string& path, bool append) {
+        if (!append) {
+            target = path;
+            temporary = temporaryPathFor(path);
+        }
+        const string& output = append ? path : temporary;
+        if (isCompressedPath(path)) {
+#ifdef TASK3_WITH_ZLIB
+            // При дозаписи в файл добавляется новый поток gzip, gunzip читает их подряд
+            compressed = gzopen(output.c_str(), append ? "ab6" : "wb6");
+            ok = compressed != nullptr;
+            if (ok) {
+                gzbuffer(compressed, 1 << 20);
+            }
+#else
+            LOG_ERROR("Ошибка: сжатый вывод недоступен, программа собрана без TASK3_WITH_ZLIB");
+#endif
+            return;
+        }
+        file.open(output, ios::binary | (append ? ios::app : ios::trunc));
+        ok = bool(file);
+    }
+
+    ~ExportSink() {
+        close();
+    }
+
+    bool isOpen() const { return ok; }
+
+    bool write(const char* data, size_t size) {
+#ifdef TASK3_WITH_ZLIB
+        if (compressed != nullptr) {
+            // gzwrite принимает unsigned, поэтому большие блоки передаются частями
+            while (ok && size > 0) {
+                unsigned part = unsigned(min<size_t>(size, 1u << 30));
+                ok = gzwrite(compressed, data, part) == int(part);
+                data += part;
+                size -= part;
+            }
+            return ok;
+        }
+#endif
+        ok = ok && bool(file.write(data, streamsize(size)));
+        return ok;
+    }
+
+    bool close() {
+#ifdef TASK3_WITH_ZLIB
+        if (compressed != nullptr) {
+            ok = gzclose(compressed) == Z_OK && ok;
+            compressed = nullptr;
+        }
+#endif
+        if (file.is_open()) {
+            file.close();
+            ok = ok && !file.fail();
+        }
+        if (!temporary.empty()) {
+            if (ok) {
+                ok = replaceFile(temporary, target);
+            } else {
+                remove(temporary.c_str());
+            }
+            temporary.clear();
+        }
+        return ok;
+    }
+};
+
+// Текстовый буфер: числа форматируются через to_chars прямо в буфер, без локали
+// и без промежуточных строк. double выводится в кратчайшей записи, которая читается
+// обратно в то же значение
+class TextBuffer {
+private:
+    vector<char> data;
+    size_t used = 0;
+
+    char* reserve(size_t extra) {
+        if (used + extra > data.size()) {
+            data.resize(max(data.size() * 2, used + extra));
+        }
+        return data.data() + used;
+    }
+
+public:
+    explicit TextBuffer(size_t capacity = 0) : data(capacity) {}
+
+    void clear() { used = 0; }
+    const char* begin() const { return data.data(); }
+    size_t size() const { return used; }
+
+    void put(char ch) {
+        *reserve(1) = ch;
+        ++used;
+    }
+
+    void write(const char* text, size_t size) {
+        memcpy(reserve(size), text, size);
+        used += size;
+    }
+
+    void write(const string& text) { write(text.data(), text.size()); }
+
+    void number(double value) {
+        char* p = reserve(32);
+        used = size_t(to_chars(p, p + 32, value).ptr - data.data());
+    }
+
+    void number(size_t value) {
+        char* p = reserve(24);
+        used = size_t(to_chars(p, p + 24, value).ptr - data.data());
+    }
+};
+
+// Примерный объем текста, который формирует одна задача форматирования
+const size_t EXPORT_CHUNK_BYTES = size_t(4) << 20;
+
+// Параллельное форматирование: count фрагментов раскладываются по буферам окнами
+// по два фрагмента на поток, затем окно записывается в приемник по порядку
+bool exportChunks(ExportSink& sink, size_t count, const function<void(size_t, TextBuffer&)>& format) {
+    size_t window = parallelWorkers() * 2;
+    vector<TextBuffer> buffers(min(window, count));
+    for (size_t start = 0; start < count && sink.isOpen(); start += window) {
+        size_t inWindow = min(window, count - start);
+        parallelTasks(inWindow, [&](size_t t, size_t) {
+            buffers[t].clear();
+            format(start + t, buffers[t]);
+        });
+        for (size_t t = 0; t < inWindow; ++t) {
+            sink.write(buffers[t].begin(), buffers[t].size());
+        }
+    }
+    return sink.isOpen();
+}
+
+// Строки плотной матрицы: значения через пробел (с пробелом в конце), строка на строку
+bool exportDenseRows(ExportSink& sink, const MatrixData& matrixData) {
+    size_t rowsPerChunk = max<size_t>(1, EXPORT_CHUNK_BYTES / 24 / max<size_t>(1, matrixData.cols));
+    size_t chunks = (matrixData.rows + rowsPerChunk - 1) / rowsPerChunk;
+    return exportChunks(sink, chunks, [&](size_t chunk, TextBuffer& out) {
+        size_t last = min<size_t>(matrixData.rows, (chunk + 1) * rowsPerChunk);
+        for (size_t i = chunk * rowsPerChunk; i < last; ++i) {
+            const double* row = matrixData.matrix.data() + i * matrixData.cols;
+            for (size_t j = 0; j < matrixData.cols; ++j) {
+                out.number(row[j]);
+                out.put(' ');
+            }
+            out.put('\n');
+        }
+    });
+}
+
+// Разреженная матрица в формате "sparse / MxN nnz / строка столбец значение"
+bool exportSparse(ExportSink& sink, const MatrixSparse<double>& sparse) {
+    TextBuffer header;
+    header.write("sparse\n");
+    header.number(size_t(sparse.rows()));
+    header.put('x');
+    header.number(size_t(sparse.cols()));
+    header.put(' ');
+    header.number(sparse.nnz());
+    header.put('\n');
+    sink.write(header.begin(), header.size());
+
+    vector<size_t> bounds = sparseRowRanges(sparse, max<size_t>(1, sparse.nnz() * 32 / EXPORT_CHUNK_BYTES));
+    return exportChunks(sink, bounds.size() - 1, [&](size_t chunk, TextBuffer& out) {
+        for (size_t i = bounds[chunk]; i < bounds[chunk + 1]; ++i) {
+            for (size_t k = sparse.rowPtr()[i]; k < sparse.rowPtr()[i + 1]; ++k) {
+                out.number(i);
+                out.put(' ');
+                out.number(size_t(sparse.colIdx()[k]));
+                out.put(' ');
+                out.number(sparse.values()[k]);
+                out.put('\n');
+            }
+        }
+    });
+}
+
+// Запись матрицы в текстовом формате "matrix / MxN / строки" или "sparse / ..." (без потери точности)
+int writeMatrixText(const string& path, const MatrixData& matrixData) {
+    ExportSink sink(path, false);
+    if (!sink.isOpen()) {
+        LOG_ERROR("Ошибка открытия файла: " + path);
+        return -1;
+    }
+    if (matrixData.isSparse) {
+        exportSparse(sink, matrixData.sparse);
+    } else {
+        TextBuffer header;
+        header.write("matrix\n");
+        header.number(size_t(matrixData.rows));
+        header.put('x');
+        header.number(size_t(matrixData.cols));
+        header.put('\n');
+        sink.write(header.begin(), header.size());
+        exportDenseRows(sink, matrixData);
+    }
+    return sink.close() ? 0 : -1;
+}
+
+// Функция для экспорта результатов рассчётов в файл. Текст формируется параллельно
+// в больших буферах и пишется несколькими крупными вызовами write; файл .mtxb
+// записывается в бинарном формате, файл .gz - сжатым
+int Export(const CalcResults& calcResults, const ExportConfig& config) {
+    if (isBinaryMatrixPath(config.path)) {
+        // Бинарный файл содержит одну матрицу, поэтому перезаписывается, а не дополняется
+        LOG_INFO("Бинарный экспорт в " + config.path);
+        if (calcResults.matrixResult.elements() > 0) {
+            if (calcResults.result.size > 0) {
+                LOG_WARNING("Предупреждение: в бинарный файл " + config.path + " записывается только матрица, "
+                            "результат-вектор (" + to_string(calcResults.result.size) + " элементов) не сохранен. "
+                            "Для него нужен отдельный --exp");
+            }
+            return writeMatrixBinary(config.path, calcResults.matrixResult);
+        }
+        if (calcResults.result.size > 0) {
+            // Вектор записывается как матрица из одной строки
+            MatrixData row;
+            row.rows = 1;
+            row.cols = unsigned(calcResults.result.size);
+            row.matrix = MatrixDense<double>(1, row.cols);
+            copy(calcResults.result.values.begin(), calcResults.result.values.end(), row.matrix.data());
+            return writeMatrixBinary(config.path, row);
+        }
+        LOG_INFO("Нет данных для записи.");
+        return 0;
+    }
+
+    // Создаю файл и открываю его на дозапись
+    LOG_INFO("Открываю " + config.path);
+    ExportSink sink(config.path, true);
+    if (!sink.isOpen()) {
+        LOG_ERROR("Ошибка открытия файла: " + config.path);
+        return -1;
+    }
+
+    // Проверка на наличие данных для записи в вектор
+    const VectorData& vectorResult = calcResults.result;
+    if (vectorResult.size > 0) {
+        const string title = "Vector Result: "; // Заголовок для вектора
+        sink.write(title.data(), title.size());
+        size_t perChunk = EXPORT_CHUNK_BYTES / 24;
+        exportChunks(sink, (vectorResult.size + perChunk - 1) / perChunk, [&](size_t chunk, TextBuffer& out) {
+            size_t last = min(vectorResult.size, (chunk + 1) * perChunk);
+            for (size_t k = chunk * perChunk; k < last; ++k) {
+                out.number(vectorResult.values[k]);
+                out.put(' ');
+            }
+        });
+        sink.write("\n", 1);
+    } else {
+        LOG_INFO("Нет данных для записи вектора, ничего не записывается в файл.");
+    }
+
+    // Проверка на наличие данных для записи в матрицу
+    const MatrixData& matrixResult = calcResults.matrixResult;
+    if (matrixResult.elements() > 0 && matrixResult.isSparse) {
+        const string title = "Sparse Matrix Result:\n"; // Разреженная матрица записывается списком ненулевых элементов
+        sink.write(title.data(), title.size());
+        exportSparse(sink, matrixResult.sparse);
+    } else if (matrixResult.elements() > 0) {
+        const string title = "Matrix Result:\n"; // Заголовок для матрицы
+        sink.write(title.data(), title.size());
+        exportDenseRows(sink, matrixResult);
+    } else {
+        LOG_INFO("Нет данных для записи матрицы.");
+    }
+
+    if (!sink.close()) { // Закрываю файл
+        LOG_ERROR("Ошибка записи в файл: " + config.path);
+        return -1;
+    }
+    return 0;
+}
+
+// Прежний экспорт матрицы через ofstream << и endl на каждой строке.
+// Оставлен только для сравнения в бенчмарке
+void exportMatrixStream(const string& path, const MatrixData& matrixData) {
+    ofstream dataFile(path, ios::app);
+    dataFile << "Matrix Result:" << endl;
+    for (unsigned i = 0; i < matrixData.rows; ++i) {
+        for (unsigned j = 0; j < matrixData.cols; ++j) {
+            dataFile << matrixData.matrix.getElement(i, j) << " ";
+        }
+        dataFile << endl;
+    }
+}
+
+// Запись строки в лог прежним способом: открыть файл, записать, закрыть.
+// Оставлена только для сравнения в бенчмарке
+void legacyLogLine(const string& path, const string& data)
+{
+    ofstream logFile(path, ios::app);
+    time_t t = time(0);
+    struct tm *now = localtime(&t);
+    logFile << put_time(now, "%Y-%m-%d %H:%M:%S") << " - " << data << endl;
+}
+
+// Генерация текстовой матрицы rows x cols для бенчмарков
+void writeBenchMatrix(const string& path, unsigned rows, unsigned cols) {
+    ofstream out(path);
+    out << "matrix\n" << rows << "x" << cols << "\n";
+    for (unsigned i = 0; i < rows; ++i) {
+        string row;
+        for (unsigned j = 0; j < cols; ++j) {
+            row += to_string(((i + j) * 7) % 1000 / 10.0).substr(0, 5) + (j + 1 < cols ? " " : "\n");
+        }
+        out << row;
+    }
+}
+
+// Бенчмарк: разбор матрицы rows x cols с прежним построчным логированием и с асинхронным логгером
+void runLogBenchmark(unsigned rows, unsigned cols) {
+    const string matrixPath = "bench_matrix.txt";
+    const string legacyLogPath = "bench_log_legacy.txt";
+    writeBenchMatrix(matrixPath, rows, cols);
+
+    // До: разбор плюс запись каждой прочитанной строки с открытием и закрытием файла
+    auto t0 = chrono::high_resolution_clock::now();
+    MatrixData before = readMatrixFromFileStream(matrixPath);
+    {
+        ifstream in(matrixPath);
+        string line;
+        while (getline(in, line)) {
+            legacyLogLine(legacyLogPath, "Чтение строки матрицы: " + line);
+        }
+    }
+    auto t1 = chrono::high_resolution_clock::now();
+
+    // После: построчные сообщения имеют уровень Debug и отсекаются при компиляции,
+    // остальные уходят в фоновый поток
+    MatrixData after = readMatrixFromFileStream(matrixPath);
+    AsyncLogger::instance().flush();
+    auto t2 = chrono::high_resolution_clock::now();
+
+    double secBefore = chrono::duration<double>(t1 - t0).count();
+    double secAfter = chrono::duration<double>(t2 - t1).count();
+    cout << "Матрица " << rows << "x" << cols << " (прочитано " << after.rows << "x" << after.cols << ")" << endl;
+    cout << "До (построчное открытие log-файла): " << secBefore << " с" << endl;
+    cout << "После (асинхронный логгер): " << secAfter << " с" << endl;
+    cout << "Ускорение: " << secBefore / secAfter << "x" << endl;
+
+    remove(matrixPath.c_str());
+    remove(legacyLogPath.c_str());
+}
+
+// Бенчмарк разбора: getline + istringstream против отображения в память + from_chars
+void runParseBenchmark(unsigned rows, unsigned cols) {
+    const string matrixPath = "bench_matrix.txt";
+    writeBenchMatrix(matrixPath, rows, cols);
+    double megabytes = 0;
+    {
+        MappedFile file(matrixPath);
+        megabytes = file.size() / 1e6;
+    }
+
+    auto t0 = chrono::high_resolution_clock::now();
+    MatrixData before = readMatrixFromFileStream(matrixPath);
+    auto t1 = chrono::high_resolution_clock::now();
+    MatrixData after = readMatrixFromFile(matrixPath);
+    auto t2 = chrono::high_resolution_clock::now();
+
+    size_t mismatches = 0;
+    if (before.rows != after.rows || before.cols != after.cols) {
+        mismatches = 1;
+    } else {
+        for (size_t k = 0; k < size_t(after.rows) * after.cols; ++k) {
+            mismatches += before.matrix.data()[k] != after.matrix.data()[k];
+        }
+    }
+
+    double secBefore = chrono::duration<double>(t1 - t0).count();
+    double secAfter = chrono::duration<double>(t2 - t1).count();
+    cout << "Матрица " << rows << "x" << cols << ", " << megabytes << " МБ, потоков: " << thread::hardware_concurrency() << endl;
+    cout << "getline + istringstream: " << secBefore << " с, " << megabytes / secBefore << " МБ/с" << endl;
+    cout << "mmap + from_chars: " << secAfter << " с, " << megabytes / secAfter << " МБ/с" << endl;
+    cout << "Ускорение: " << secBefore / secAfter << "x, расхождений: " << mismatches << endl;
+
+    remove(matrixPath.c_str());
+}
+
+// Бенчмарк пула: цепочка сложений, где каждая операция создает временную матрицу той же формы
+void runPoolBenchmark(unsigned rows, unsigned cols, unsigned iterations) {
+    MatrixData a, b;
+    a.rows = b.rows = rows;
+    a.cols = b.cols = cols;
+    a.matrix = MatrixDense<double>(rows, cols);
+    b.matrix = MatrixDense<double>(rows, cols);
+    for (size_t k = 0; k < size_t(rows) * cols; ++k) {
+        a.matrix.data()[k] = double(k % 100);
+        b.matrix.data()[k] = 1.0;
+    }
+
+    auto runChain = [&]() {
+        MatrixData acc = a;
+        for (unsigned it = 0; it < iterations; ++it) {
+            acc = Calck_mm_sum(acc, b);
+        }
+        return acc.matrix.getElement(rows - 1, cols - 1);
+    };
+
+    auto t0 = chrono::high_resolution_clock::now();
+    double plain = runChain();
+    auto t1 = chrono::high_resolution_clock::now();
+    double pooled = 0;
+    {
+        MatrixPool pool;
+        MatrixPoolScope scope(pool);
+        pooled = runChain();
+    }
+    auto t2 = chrono::high_resolution_clock::now();
+
+    double secPlain = chrono::duration<double>(t1 - t0).count();
+    double secPooled = chrono::duration<double>(t2 - t1).count();
+    cout << "Матрица " << rows << "x" << cols << ", операций: " << iterations << endl;
+    cout << "Без пула: " << secPlain * 1e3 / iterations << " мс/операция" << endl;
+    cout << "С пулом: " << secPooled * 1e3 / iterations << " мс/операция" << endl;
+    cout << "Ускорение: " << secPlain / secPooled << "x, результаты " << (plain == pooled ? "совпадают" : "РАЗЛИЧАЮТСЯ") << endl;
+}
 
-int logAll(string data)
-{
-    ofstream logFile("log.txt", ios::app); // Открываем файл в режиме добавления
-    if (!logFile) {
-        return -1;
+// Бенчмарк a + b - c * k над векторами из n элементов: отдельные проходы с временными
+// массивами (как при цепочке Calck_*), шаблоны выражений и выражение из строки
+void runExpressionBenchmark(size_t n) {
+    VectorData operands[FusedExpression::MAX_OPERANDS];
+    for (int k = 0; k < FusedExpression::MAX_OPERANDS; ++k) {
+        operands[k].size = n;
+        operands[k].values.resize(n);
+        for (size_t i = 0; i < n; ++i) {
+            operands[k].values[i] = double((i * (k + 3)) % 101) / 7.0;
+        }
     }
-    //ios::app — это флаг, который указывает, что файл должен быть открыт в режиме добавления
-    time_t t = time(0); // Получаю текущее время
-    struct tm *now = localtime(&t); // Преобразую в локальное время
+    const VectorData& a = operands[0];
+    const VectorData& b = operands[1];
+    const VectorData& c = operands[2];
+    const double k = 2.5;
+    const int repeats = 5;
 
-    // Записываем дату и время в файл
-    logFile <<put_time(now, "%Y-%m-%d %H:%M:%S") << " - "; // Форматирую и записываем дату и время
+    auto t0 = chrono::high_resolution_clock::now();
+    VectorData separate;
+    for (int r = 0; r < repeats; ++r) {
+        VectorData scaled;
+        scaled.size = c.size;
+        scaled.values.resize(n);
+        for (size_t i = 0; i < n; ++i) {
+            scaled.values[i] = c.values[i] * k;
+        }
+        separate = Calck_vv_sub(Calck_vv_sum(a, b), scaled);
+    }
+    auto t1 = chrono::high_resolution_clock::now();
+    vector<double> fused(n);
+    for (int r = 0; r < repeats; ++r) {
+        evaluateInto(asExpr(a) + asExpr(b) - asExpr(c) * k, fused.data(), n);
+    }
+    auto t2 = chrono::high_resolution_clock::now();
+    CalcResults parsed;
+    MatrixData noMatrices[FusedExpression::MAX_OPERANDS];
+    const VectorData* vectorOperands[] = {&a, &b, &c};
+    const MatrixData* matrixOperands[] = {&noMatrices[0], &noMatrices[1], &noMatrices[2]};
+    for (int r = 0; r < repeats; ++r) {
+        Calck_expression("a + b - c * 2.5", vectorOperands, matrixOperands, parsed);
+    }
+    auto t3 = chrono::high_resolution_clock::now();
 
-    logFile << data << endl; // Записываю данные в файл
-    logFile.close(); // Закрываю файл
-    return 0; 
+    size_t mismatches = 0;
+    for (size_t i = 0; i < n; ++i) {
+        mismatches += separate.values[i] != fused[i] || fused[i] != parsed.result.values[i];
+    }
+    auto ms = [&](chrono::high_resolution_clock::time_point from, chrono::high_resolution_clock::time_point to) {
+        return chrono::duration<double>(to - from).count() * 1e3 / repeats;
+    };
+    cout << "a + b - c * k, n = " << n << endl;
+    cout << "Отдельные проходы: " << ms(t0, t1) << " мс" << endl;
+    cout << "Шаблоны выражений: " << ms(t1, t2) << " мс" << endl;
+    cout << "Выражение из строки: " << ms(t2, t3) << " мс" << endl;
+    cout << "Расхождений: " << mismatches << endl;
 }
 
-//Функция для чтения из файлов и проверки значений
-VectorData readDataFromFile(const string& filepath) {
-    string line;
-    VectorData vectorData;
-    ifstream dataFile(filepath); // Открываем файл в режиме чтения
-    if (!dataFile) {
-        logAll("Ошибка открытия файла");
-        return vectorData; // Возвращаем пустой вектор
+// Бенчмарк умножения n x n: наивный тройной цикл против блочного умножения
+void runGemmBenchmark(unsigned n) {
+    MatrixData a, b;
+    a.rows = a.cols = b.rows = b.cols = n;
+    a.matrix = MatrixDense<double>(n, n);
+    b.matrix = MatrixDense<double>(n, n);
+    for (size_t k = 0; k < size_t(n) * n; ++k) {
+        a.matrix.data()[k] = double(k % 17) / 16.0 - 0.5;
+        b.matrix.data()[k] = double(k % 13) / 12.0 - 0.5;
     }
 
-    while (getline(dataFile, line)) {
-        logAll(line);
-        if (line == "vector") {
-            logAll("В файле обнаружено значение vector");
-            // Читаем размер вектора
-            if (getline(dataFile, line)) {
-                vectorData.size = stoi(line);
-                vectorData.values.resize(vectorData.size);
-                // Читаем значения вектора
-                if (getline(dataFile, line)) {
-                    /*Istringstream - это строковой поток ввода. Конструктор istringstream () со строковым аргументом прикрепляет создаваемый объект потока к указанной строке. То есть теперь информация будет считываться из стандартной строки точно таким же образом, как и из cin, объекта класса потока ввода istream.*/
-                    istringstream iss(line);
-                    for (int i = 0; i < vectorData.size; ++i) {
-                        iss >> vectorData.values[i];
-                    }
-                }
+    auto t0 = chrono::high_resolution_clock::now();
+    MatrixDense<double> naive(n, n);
+    for (unsigned i = 0; i < n; ++i) {
+        for (unsigned j = 0; j < n; ++j) {
+            double sum = 0;
+            for (unsigned p = 0; p < n; ++p) {
+                sum += a.matrix.getElement(i, p) * b.matrix.getElement(p, j);
             }
+            naive.getElement(i, j) = sum;
         }
     }
-    dataFile.close(); // Закрываем файл
-    return vectorData; 
-}
+    auto t1 = chrono::high_resolution_clock::now();
+    MatrixData blocked = Calck_mm_mul(a, b);
+    auto t2 = chrono::high_resolution_clock::now();
 
-//Функция для чтения данных матрицы из файла
-MatrixData readMatrixFromFile(const string& filepath) {
-    string line;
-    MatrixData matrixData;
-    ifstream dataFile(filepath);
-    
-    if (!dataFile) {
-        logAll("Ошибка открытия файла: " + filepath);
-        return matrixData;
+    double maxError = 0;
+    for (size_t k = 0; k < size_t(n) * n; ++k) {
+        maxError = max(maxError, fabs(naive.data()[k] - blocked.matrix.data()[k]));
     }
+    double flops = 2.0 * n * n * n;
+    double secNaive = chrono::duration<double>(t1 - t0).count();
+    double secBlocked = chrono::duration<double>(t2 - t1).count();
+    cout << "Умножение " << n << "x" << n << ", ядро " << gemmKernel().name << ", потоков: " << thread::hardware_concurrency() << endl;
+    cout << "Тройной цикл: " << secNaive << " с, " << flops / secNaive * 1e-9 << " GFLOP/s" << endl;
+    cout << "Блочное: " << secBlocked << " с, " << flops / secBlocked * 1e-9 << " GFLOP/s" << endl;
+    cout << "Ускорение: " << secNaive / secBlocked << "x, максимальная разница: " << maxError << endl;
+}
 
-    while (getline(dataFile, line)) {
-        logAll("Чтение строки: " + line);
-        if (line == "matrix") {
-            logAll("В файле обнаружено значение 'matrix'");
-            if (getline(dataFile, line)) {
-                // Изменяем формат чтения размеров матрицы
-                size_t xPos = line.find('x');
-                if (xPos != string::npos) {
-                    matrixData.rows = stoi(line.substr(0, xPos));
-                    matrixData.cols = stoi(line.substr(xPos + 1));
-                    logAll("Размеры матрицы: " + to_string(matrixData.rows) + "x" + to_string(matrixData.cols));
-                } else {
-                    logAll("Ошибка: неверный формат размеров матрицы. Ожидалось 'MxN'.");
-                    return matrixData; // Возвращаем пустую матрицу в случае ошибки
+// Бенчмарк прямых решателей для n из sizes: LU для несимметричной матрицы с диагональным
+// преобладанием и Холецкий для симметричной положительно определенной; повторное решение
+// с готовым разложением для 1 и 64 правых частей. Для n <= 2048 - сравнение с
+// неблочным исключением Гаусса
+void runSolveBenchmark(const vector<unsigned>& sizes) {
+    cout << "Решение систем, блок " << LinearSolver::BLOCK << ", ядро " << gemmKernel().name
+         << ", потоков: " << parallelWorkers() << endl;
+    for (unsigned n : sizes) {
+        MatrixData a;
+        a.rows = a.cols = n;
+        a.matrix = MatrixDense<double>(n, n);
+        uint64_t state = 12345;
+        auto random = [&state]() {
+            state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+            return double(state >> 11) / double(1ULL << 53) - 0.5;
+        };
+        for (size_t k = 0; k < size_t(n) * n; ++k) {
+            a.matrix.data()[k] = random();
+        }
+        for (unsigned i = 0; i < n; ++i) {
+            a.matrix.getElement(i, i) += n;
+        }
+        const size_t nrhs = 64;
+        vector<double, AlignedAllocator<double>> b(size_t(n) * nrhs), x;
+        for (double& value : b) {
+            value = random();
+        }
+
+        // Невязка max|A x - b| / (max|A| * max|x|) для первой правой части
+        auto residual = [&](const MatrixData& m, const double* solution, size_t stride) {
+            vector<double> column(n), ax(n);
+            double normA = 0, normX = 0, worst = 0;
+            for (unsigned i = 0; i < n; ++i) {
+                column[i] = solution[i * stride];
+                normX = max(normX, fabs(column[i]));
+            }
+            gemm(n, 1, n, m.matrix.data(), n, column.data(), 1, ax.data(), 1);
+            for (size_t k = 0; k < size_t(n) * n; ++k) {
+                normA = max(normA, fabs(m.matrix.data()[k]));
+            }
+            for (unsigned i = 0; i < n; ++i) {
+                worst = max(worst, fabs(ax[i] - b[i * nrhs]));
+            }
+            return worst / (normA * normX);
+        };
+
+        LinearSolver lu;
+        auto t0 = chrono::high_resolution_clock::now();
+        lu.factor(a, FactorizationKind::LU);
+        auto t1 = chrono::high_resolution_clock::now();
+        x.assign(n, 0.0);
+        for (unsigned i = 0; i < n; ++i) {
+            x[i] = b[i * nrhs];
+        }
+        lu.solve(x.data(), 1);
+        auto t2 = chrono::high_resolution_clock::now();
+        vector<double, AlignedAllocator<double>> many(b);
+        lu.solve(many.data(), nrhs);
+        auto t3 = chrono::high_resolution_clock::now();
+        double secLU = chrono::duration<double>(t1 - t0).count();
+        cout << "n = " << n << endl;
+        cout << "  LU: " << secLU << " с, " << 2.0 / 3.0 * n * n * double(n) / secLU * 1e-9 << " GFLOP/s, невязка "
+             << residual(a, x.data(), 1) << endl;
+        cout << "  Повторное решение: 1 правая часть " << chrono::duration<double>(t2 - t1).count() * 1e3 << " мс, "
+             << nrhs << " правых частей " << chrono::duration<double>(t3 - t2).count() * 1e3 << " мс, невязка "
+             << residual(a, many.data(), nrhs) << endl;
+
+        if (n <= 2048) {
+            // Неблочный вариант (строки-ядра в порядке i-k-j) для сравнения
+            MatrixDense<double> plain = a.matrix;
+            auto t4 = chrono::high_resolution_clock::now();
+            for (unsigned k = 0; k < n; ++k) {
+                unsigned p = k;
+                for (unsigned i = k + 1; i < n; ++i) {
+                    if (fabs(plain.getElement(i, k)) > fabs(plain.getElement(p, k))) p = i;
                 }
-                
-                matrixData.matrix = MatrixDense<double>(matrixData.rows, matrixData.cols);
-                
-                // Читаем значения матрицы
-                for (unsigned i = 0; i < matrixData.rows; ++i) {
-                    if (getline(dataFile, line)) {
-                        logAll("Чтение строки матрицы: " + line);
-                        istringstream iss(line);
-                        for (unsigned j = 0; j < matrixData.cols; ++j) {
-                            if (!(iss >> matrixData.matrix.getElement(i, j))) {
-                                logAll("Ошибка: не удалось прочитать элемент матрицы на позиции (" + to_string(i) + ", " + to_string(j) + ")");
-                                return matrixData; // Возвращаем пустую матрицу в случае ошибки
-                            }
-                        }
-                    } else {
-                        logAll("Ошибка: недостаточно строк для матрицы. Ожидалось " + to_string(matrixData.rows) + " строк.");
-                        return matrixData; // Возвращаем пустую матрицу в случае ошибки
+                for (unsigned j = 0; j < n; ++j) {
+                    swap(plain.getElement(k, j), plain.getElement(p, j));
+                }
+                for (unsigned i = k + 1; i < n; ++i) {
+                    double l = plain.getElement(i, k) /= plain.getElement(k, k);
+                    for (unsigned j = k + 1; j < n; ++j) {
+                        plain.getElement(i, j) -= l * plain.getElement(k, j);
                     }
                 }
             }
+            double secPlain = chrono::duration<double>(chrono::high_resolution_clock::now() - t4).count();
+            cout << "  Неблочное LU: " << secPlain << " с, ускорение " << secPlain / secLU << "x" << endl;
+        }
+
+        // Симметричная положительно определенная матрица: (A + A^T) / 2 с тем же преобладанием диагонали
+        for (unsigned i = 0; i < n; ++i) {
+            for (unsigned j = 0; j < i; ++j) {
+                double value = 0.5 * (a.matrix.getElement(i, j) + a.matrix.getElement(j, i));
+                a.matrix.getElement(i, j) = a.matrix.getElement(j, i) = value;
+            }
         }
+        LinearSolver cholesky;
+        auto t5 = chrono::high_resolution_clock::now();
+        cholesky.factor(a);
+        double secCholesky = chrono::duration<double>(chrono::high_resolution_clock::now() - t5).count();
+        for (unsigned i = 0; i < n; ++i) {
+            x[i] = b[i * nrhs];
+        }
+        cholesky.solve(x.data(), 1);
+        cout << "  " << (cholesky.type() == FactorizationKind::Cholesky ? "Холецкий" : "LU") << " (SPD): " << secCholesky
+             << " с, " << 1.0 / 3.0 * n * n * double(n) / secCholesky * 1e-9 << " GFLOP/s, невязка "
+             << residual(a, x.data(), 1) << endl;
     }
-    
-    dataFile.close();
-    return matrixData;
 }
 
-//Функция для сложения матриц
-MatrixData Calck_mm_sum(const MatrixData& mat1, const MatrixData& mat2) {
-    // Проверка на равенство размерностей
-    if (mat1.rows != mat2.rows || mat1.cols != mat2.cols) {
-        logAll("Ошибка! Размерности матриц не совпадают");
-        return MatrixData();
+// Бенчмарк итерационных методов на сетке grid x grid: пятиточечный оператор Лапласа
+// (симметричная положительно определенная матрица, как в неявной схеме теплопроводности)
+// и тот же оператор с конвективным членом (несимметричная). Точное решение - единицы
+void runIterativeBenchmark(unsigned grid) {
+    const unsigned n = grid * grid;
+    auto buildMatrix = [&](double convection) {
+        vector<SparseEntry<double>> entries;
+        entries.reserve(size_t(n) * 5);
+        for (unsigned y = 0; y < grid; ++y) {
+            for (unsigned x = 0; x < grid; ++x) {
+                unsigned i = y * grid + x;
+                entries.push_back({i, i, 4.0 + convection});
+                if (x > 0) entries.push_back({i, i - 1, -1.0 - convection});
+                if (x + 1 < grid) entries.push_back({i, i + 1, -1.0});
+                if (y > 0) entries.push_back({i, i - grid, -1.0});
+                if (y + 1 < grid) entries.push_back({i, i + grid, -1.0});
+            }
+        }
+        MatrixData a;
+        a.rows = a.cols = n;
+        a.isSparse = true;
+        a.sparse = MatrixSparse<double>::fromEntries(n, n, entries);
+        return a;
+    };
+
+    cout << "Итерационные методы, сетка " << grid << "x" << grid << " (" << n << " неизвестных), потоков: "
+         << parallelWorkers() << endl;
+    struct Case { const char* title; double convection; IterativeMethod method; PreconditionerKind precond; };
+    const Case cases[] = {
+        {"Лаплас", 0.0, IterativeMethod::CG, PreconditionerKind::None},
+        {"Лаплас", 0.0, IterativeMethod::CG, PreconditionerKind::Jacobi},
+        {"Лаплас", 0.0, IterativeMethod::CG, PreconditionerKind::ILU0},
+        {"Лаплас", 0.0, IterativeMethod::BiCGStab, PreconditionerKind::ILU0},
+        {"Лаплас", 0.0, IterativeMethod::GMRES, PreconditionerKind::ILU0},
+        {"Конвекция", 1.0, IterativeMethod::BiCGStab, PreconditionerKind::None},
+        {"Конвекция", 1.0, IterativeMethod::BiCGStab, PreconditionerKind::ILU0},
+        {"Конвекция", 1.0, IterativeMethod::GMRES, PreconditionerKind::ILU0},
+    };
+    const char* precondNames[] = {"нет", "Якоби", "ILU(0)"};
+    IterativeOptions options;
+    options.tolerance = 1e-8;
+    MatrixData a;
+    double builtFor = -1;
+    for (const Case& c : cases) {
+        if (c.convection != builtFor) {
+            a = buildMatrix(c.convection);
+            builtFor = c.convection;
+        }
+        KrylovVector ones(n, 1.0), b(n), x(n, 0.0), check(n);
+        spmv(a.sparse, ones.data(), b.data());
+
+        SparseOperator op(a.sparse);
+        auto t0 = chrono::high_resolution_clock::now();
+        unique_ptr<Preconditioner> m;
+        if (c.precond == PreconditionerKind::ILU0) {
+            m.reset(new ILU0Preconditioner(a.sparse));
+        } else if (c.precond == PreconditionerKind::Jacobi) {
+            m.reset(new JacobiPreconditioner(a));
+        } else {
+            m.reset(new IdentityPreconditioner(n));
+        }
+        double setup = chrono::duration<double>(chrono::high_resolution_clock::now() - t0).count();
+        IterativeStats stats = solveIterative(c.method, op, *m, b.data(), x.data(), options);
+
+        spmv(a.sparse, x.data(), check.data());
+        double residual = 0, error = 0;
+        for (unsigned i = 0; i < n; ++i) {
+            residual += (b[i] - check[i]) * (b[i] - check[i]);
+            error = max(error, fabs(x[i] - 1.0));
+        }
+        cout << c.title << ", " << iterativeMethodName(c.method) << ", предобусловливатель " << precondNames[int(c.precond)]
+             << ": " << (stats.converged ? "" : "не сошелся, ") << stats.iterations << " итераций, "
+             << stats.seconds << " с (+" << setup << " с подготовка), " << stats.secondsPerIteration() * 1e3
+             << " мс/итерация, невязка " << sqrt(residual) / krylovNorm(b.data(), n) << ", ошибка " << error << endl;
+        // История невязки: пять равномерно выбранных точек и последняя итерация
+        cout << "  история:";
+        size_t step = max<size_t>(1, stats.residuals.size() / 5);
+        for (size_t k = 0; k < stats.residuals.size(); k += step) {
+            cout << " [" << k << "] " << stats.residuals[k];
+        }
+        if ((stats.residuals.size() - 1) % step != 0) {
+            cout << " [" << stats.residuals.size() - 1 << "] " << stats.residuals.back();
+        }
+        cout << endl;
     }
+}
 
-    MatrixData result; // Создаем объект для хранения результата сложения матриц
-    result.rows = mat1.rows; // Устанавливаем размер результирующей матрицы
-    result.cols = mat1.cols;
-    result.matrix = MatrixDense<double>(result.rows, result.cols); // Инициализируем матрицу
+// Бенчмарк разреженных операций n x n с долей ненулевых density: сложение и умножение
+// на вектор в CSR против тех же операций над плотным представлением
+void runSparseBenchmark(unsigned n, double density) {
+    size_t nnz = size_t(double(n) * n * density);
+    auto randomSparse = [&](unsigned seed) {
+        vector<SparseEntry<double>> entries(nnz);
+        uint64_t state = seed;
+        for (auto& e : entries) {
+            state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+            e.row = unsigned((state >> 33) % n);
+            state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+            e.col = unsigned((state >> 33) % n);
+            e.value = double((state >> 40) % 1000) / 100.0;
+        }
+        MatrixData m;
+        m.rows = m.cols = n;
+        m.isSparse = true;
+        m.sparse = MatrixSparse<double>::fromEntries(n, n, entries);
+        return m;
+    };
+    auto toDense = [&](const MatrixData& sparse) {
+        MatrixData m;
+        m.rows = m.cols = n;
+        m.matrix = MatrixDense<double>(n, n);
+        fill(m.matrix.data(), m.matrix.data() + size_t(n) * n, 0.0);
+        return sparseSum(m, sparse);
+    };
+    MatrixData a = randomSparse(1), b = randomSparse(2);
+    MatrixData denseA = toDense(a), denseB = toDense(b);
+    VectorData x;
+    x.size = n;
+    x.values.assign(n, 1.0);
 
-    // Сложение матриц
-    for (unsigned i = 0; i < result.rows; ++i) {
-        for (unsigned j = 0; j < result.cols; ++j) {
-            result.matrix.getElement(i, j) = mat1.matrix.getElement(i, j) + mat2.matrix.getElement(i, j);
+    auto t0 = chrono::high_resolution_clock::now();
+    MatrixData sparseSumResult = Calck_mm_sum(a, b);
+    auto t1 = chrono::high_resolution_clock::now();
+    MatrixData denseSumResult = Calck_mm_sum(denseA, denseB);
+    auto t2 = chrono::high_resolution_clock::now();
+    VectorData sparseY = Calck_mv_mul(a, x);
+    auto t3 = chrono::high_resolution_clock::now();
+    VectorData denseY = Calck_mv_mul(denseA, x);
+    auto t4 = chrono::high_resolution_clock::now();
+
+    double maxError = 0;
+    MatrixData check = toDense(sparseSumResult);
+    for (size_t k = 0; k < size_t(n) * n; ++k) {
+        maxError = max(maxError, fabs(check.matrix.data()[k] - denseSumResult.matrix.data()[k]));
+    }
+    for (unsigned i = 0; i < n; ++i) {
+        maxError = max(maxError, fabs(sparseY.values[i] - denseY.values[i]));
+    }
+    auto ms = [](chrono::high_resolution_clock::time_point from, chrono::high_resolution_clock::time_point to) {
+        return chrono::duration<double>(to - from).count() * 1e3;
+    };
+    size_t sparseBytes = a.sparse.nnz() * (sizeof(double) + sizeof(unsigned)) + (size_t(n) + 1) * sizeof(size_t);
+    cout << "Матрица " << n << "x" << n << ", ненулевых: " << a.sparse.nnz() << endl;
+    cout << "Память: CSR " << sparseBytes / 1e6 << " МБ, плотная " << double(n) * n * sizeof(double) / 1e6 << " МБ" << endl;
+    cout << "Сложение: CSR " << ms(t0, t1) << " мс, плотное " << ms(t1, t2) << " мс" << endl;
+    cout << "Умножение на вектор: CSR " << ms(t2, t3) << " мс, плотное " << ms(t3, t4) << " мс" << endl;
+    cout << "Максимальная разница: " << maxError << endl;
+}
+
+// Бенчмарк поэлементных операций над n элементами: прежние циклы (индексы unsigned,
+// getElement, один поток) против SIMD-ядер на пуле потоков. Пропускная способность
+// считается по трем массивам (два чтения и запись)
+void runElementwiseBenchmark(size_t n) {
+    unsigned cols = 1000;
+    unsigned rows = unsigned((n + cols - 1) / cols);
+    n = size_t(rows) * cols;
+    MatrixData a, b;
+    a.rows = b.rows = rows;
+    a.cols = b.cols = cols;
+    a.matrix = MatrixDense<double>(rows, cols);
+    b.matrix = MatrixDense<double>(rows, cols);
+    parallelRanges(n, 8, [&](size_t begin, size_t end) {
+        for (size_t k = begin; k < end; ++k) {
+            a.matrix.data()[k] = double(k % 1000);
+            b.matrix.data()[k] = 0.5;
+        }
+    });
+
+    auto t0 = chrono::high_resolution_clock::now();
+    MatrixDense<double> legacy(rows, cols);
+    for (unsigned i = 0; i < rows; ++i) {
+        for (unsigned j = 0; j < cols; ++j) {
+            legacy.getElement(i, j) = a.matrix.getElement(i, j) + b.matrix.getElement(i, j);
         }
     }
+    auto t1 = chrono::high_resolution_clock::now();
+    MatrixPool pool;
+    MatrixPoolScope scope(pool);
+    {
+        MatrixData first = Calck_mm_sum(a, b); // Первый вызов включает первое касание страниц результата
+    }
+    auto t2 = chrono::high_resolution_clock::now();
+    MatrixData second = Calck_mm_sum(a, b); // Буфер результата взят из пула, страницы уже размещены
+    auto t3 = chrono::high_resolution_clock::now();
 
-    return result;
+    size_t mismatches = 0;
+    for (size_t k = 0; k < n; ++k) {
+        mismatches += second.matrix.data()[k] != legacy.data()[k];
+    }
+    double gigabytes = 3.0 * n * sizeof(double) / 1e9;
+    auto report = [&](const char* title, chrono::high_resolution_clock::time_point from, chrono::high_resolution_clock::time_point to) {
+        double sec = chrono::duration<double>(to - from).count();
+        cout << title << sec * 1e3 << " мс, " << gigabytes / sec << " ГБ/с" << endl;
+    };
+    cout << "mm_sum, " << n << " элементов, ядро " << elementwiseKernels().name << ", потоков: " << parallelWorkers() << endl;
+    report("Прежний цикл: ", t0, t1);
+    report("SIMD + пул (новый результат): ", t1, t2);
+    report("SIMD + пул (буфер из MatrixPool): ", t2, t3);
+    cout << "Расхождений: " << mismatches << endl;
 }
 
-// Функция для сложения двух векторов
-VectorData Calck_vv_sum(const VectorData& vec1, const VectorData& vec2) {
-    // Проверка на равенство размерностей
-    if (vec1.size != vec2.size) {
-        logAll("Ошибка! Размерность векторов не совпадает");
-        return VectorData();
+// Бенчмарк экспорта матрицы rows x cols: ofstream << против to_chars и крупных буферов
+void runExportBenchmark(unsigned rows, unsigned cols) {
+    CalcResults results;
+    MatrixData& m = results.matrixResult;
+    m.rows = rows;
+    m.cols = cols;
+    m.matrix = MatrixDense<double>(rows, cols);
+    for (size_t k = 0; k < m.elements(); ++k) {
+        m.matrix.data()[k] = double(k % 100003) / 7.0;
     }
+    const string legacyPath = "bench_export_legacy.txt";
+    const string fastPath = "bench_export.txt";
+    const string binaryPath = "bench_export.mtxb";
+    remove(legacyPath.c_str());
+    remove(fastPath.c_str());
 
-    VectorData result; // Создаем объект для хранения результата сложения векторов
-    result.size = vec1.size; // Устанавливаем размер результирующего вектора равным размеру первого вектора
-    result.values.resize(result.size); // Изменяем размер массива значений результирующего вектора
+    auto t0 = chrono::high_resolution_clock::now();
+    exportMatrixStream(legacyPath, m);
+    auto t1 = chrono::high_resolution_clock::now();
+    ExportConfig conf;
+    conf.path = fastPath;
+    Export(results, conf);
+    auto t2 = chrono::high_resolution_clock::now();
+    conf.path = binaryPath;
+    Export(results, conf);
+    auto t3 = chrono::high_resolution_clock::now();
 
-    // Сложение векторов
-    for (int i = 0; i < result.size; ++i) {
-        result.values[i] = vec1.values[i] + vec2.values[i];
+    // Проверка: значения, прочитанные из нового текстового вывода, совпадают точно
+    MatrixData check;
+    {
+        MappedFile file(fastPath);
+        const char* p = file.begin();
+        const char* lb;
+        const char* le;
+        nextLine(p, file.end(), lb, le); // Заголовок "Matrix Result:"
+        check.rows = rows;
+        check.cols = cols;
+        check.matrix = MatrixDense<double>(rows, cols);
+        if (!parseMatrixRows(p, file.end(), check.matrix, rows, cols).empty()) {
+            check.rows = 0;
+        }
+    }
+    size_t mismatches = check.rows == 0 ? m.elements() : 0;
+    for (size_t k = 0; check.rows != 0 && k < m.elements(); ++k) {
+        mismatches += check.matrix.data()[k] != m.matrix.data()[k];
     }
 
-    return result;
+    auto sec = [](chrono::high_resolution_clock::time_point from, chrono::high_resolution_clock::time_point to) {
+        return chrono::duration<double>(to - from).count();
+    };
+    cout << "Экспорт матрицы " << rows << "x" << cols << ", потоков: " << parallelWorkers() << endl;
+    cout << "ofstream <<: " << sec(t0, t1) << " с (6 значащих цифр)" << endl;
+    cout << "to_chars + буферы: " << sec(t1, t2) << " с (кратчайшая точная запись)" << endl;
+    cout << "Бинарный .mtxb: " << sec(t2, t3) << " с" << endl;
+    cout << "Расхождений после чтения нового вывода: " << mismatches << endl;
+
+    remove(legacyPath.c_str());
+    remove(fastPath.c_str());
+    remove(binaryPath.c_str());
 }
 
-//Функция для вычитания векторов
-VectorData Calck_vv_sub(const VectorData& vec1, const VectorData& vec2) {
-    // Проверка на равенство размерностей
-    if (vec1.size != vec2.size) {
-        logAll("Ошибка! Размерность векторов не совпадает");
-        return VectorData();
+// Конвертация матрицы между текстовым и бинарным форматом: формат входа определяется
+// автоматически, выход записывается в другом формате
+int convertMatrixFile(const string& input, const string& output) {
+    bool inputBinary = false;
+    {
+        MappedFile file(input);
+        inputBinary = isBinaryMatrix(file.begin(), file.end());
+    }
+    MatrixData matrixData = readMatrixFromFile(input);
+    if (matrixData.elements() == 0) {
+        LOG_ERROR("Ошибка: не удалось прочитать матрицу для конвертации: " + input);
+        return -1;
     }
+    LOG_INFO("Конвертация " + input + " -> " + output);
+    return inputBinary ? writeMatrixText(output, matrixData) : writeMatrixBinary(output, matrixData);
+}
 
-    VectorData result; // Создаем объект для хранения результата вычитания векторов
-    result.size = vec1.size; // Устанавливаем размер результирующего вектора равным размеру первого вектора
-    result.values.resize(result.size); // Изменяем размер массива значений результирующего вектора
+// Бенчмарк загрузки: текстовый разбор против отображения бинарного файла
+void runBinaryBenchmark(unsigned rows, unsigned cols) {
+    const string textPath = "bench_matrix.txt";
+    const string binaryPath = "bench_matrix.mtxb";
+    writeBenchMatrix(textPath, rows, cols);
+    convertMatrixFile(textPath, binaryPath);
 
-    // Вычитание векторов
-    for (int i = 0; i < result.size; ++i) {
-        result.values[i] = vec1.values[i] - vec2.values[i];
+    auto t0 = chrono::high_resolution_clock::now();
+    MatrixData text = readMatrixFromFile(textPath);
+    auto t1 = chrono::high_resolution_clock::now();
+    MatrixData binary = readMatrixFromFile(binaryPath);
+    auto t2 = chrono::high_resolution_clock::now();
+    // Первое обращение к данным отображенного файла (подгрузка страниц)
+    double sum = 0;
+    for (size_t k = 0; k < size_t(binary.rows) * binary.cols; ++k) {
+        sum += binary.matrix.data()[k];
     }
+    auto t3 = chrono::high_resolution_clock::now();
 
-    return result;
+    size_t mismatches = 0;
+    for (size_t k = 0; k < size_t(text.rows) * text.cols; ++k) {
+        mismatches += text.matrix.data()[k] != binary.matrix.data()[k];
+    }
+    cout << "Матрица " << rows << "x" << cols << endl;
+    cout << "Текст (mmap + from_chars): " << chrono::duration<double>(t1 - t0).count() << " с" << endl;
+    cout << "Бинарный (mmap): " << chrono::duration<double>(t2 - t1).count() * 1e3 << " мс, первый проход по данным: "
+         << chrono::duration<double>(t3 - t2).count() * 1e3 << " мс (сумма " << sum << ")" << endl;
+    cout << "Расхождений: " << mismatches << endl;
+
+    remove(textPath.c_str());
+    remove(binaryPath.c_str());
 }
 
-// Функция для экспорта результатов рассчётов в файл
-int Export(const CalcResults& calcResults, const ExportConfig& config) {
-    // Создаю файл и открываю его на дозапись
-    logAll("Открываю " + config.path);
-    ofstream dataFile(config.path, ios::app); // Открываем файл в режиме добавления
-    if (!dataFile) {
-        logAll("Ошибка открытия файла: " + config.path);
-        return -1;
+// Разложение матрицы системы с записью в лог времени и выбранного метода
+LinearSolver factorMatrix(const MatrixData& a) {
+    LinearSolver solver;
+    auto t0 = chrono::high_resolution_clock::now();
+    if (solver.factor(a)) {
+        double seconds = chrono::duration<double>(chrono::high_resolution_clock::now() - t0).count();
+        LOG_INFO(string("Разложение ") + (solver.type() == FactorizationKind::Cholesky ? "Холецкого" : "LU") +
+                 " " + to_string(solver.size()) + "x" + to_string(solver.size()) + " за " + to_string(seconds) + " с");
     }
+    return solver;
+}
 
-    // Проверка на наличие данных для записи в вектор
-    if (calcResults.result.size > 0) {
-        dataFile << "Vector Result: "; // Заголовок для вектора
+// Кэш операндов пакетного режима: файл, который указан в нескольких заданиях,
+// читается один раз. Первое задание, запросившее путь, загружает файл, остальные
+// ждут его shared_future; загруженные операнды только читаются и общие для всех потоков
+class OperandCache {
+private:
+    mutex lock;
+    map<string, shared_future<shared_ptr<const VectorData>>> vectors;
+    map<string, shared_future<shared_ptr<const MatrixData>>> matrices;
+    map<string, shared_future<shared_ptr<const LinearSolver>>> solvers;
 
-        // Записываем данные вектора в файл
-        for (const auto& value : calcResults.result.values) {
-            dataFile << value << " "; // Записываем значения вектора
+    template<typename Data, typename Loader>
+    static shared_ptr<const Data> get(mutex& lock, map<string, shared_future<shared_ptr<const Data>>>& entries,
+                                      const string& path, Loader load) {
+        promise<shared_ptr<const Data>> loading;
+        shared_future<shared_ptr<const Data>> result;
+        bool owner = false;
+        {
+            lock_guard<mutex> guard(lock);
+            auto it = entries.find(path);
+            if (it == entries.end()) {
+                result = loading.get_future().share();
+                entries.emplace(path, result);
+                owner = true;
+            } else {
+                result = it->second;
+            }
         }
-        dataFile << endl; // Переход на новую строку
-    } else {
-        logAll("Нет данных для записи вектора, ничего не записывается в файл.");
+        if (owner) {
+            // Ошибка загрузки достается и заданиям, ожидающим этот операнд
+            try {
+                loading.set_value(make_shared<const Data>(load(path)));
+            } catch (...) {
+                loading.set_exception(current_exception());
+            }
+        } else {
+            LOG_INFO("Операнд взят из кэша: " + path);
+        }
+        return result.get();
+    }
+
+public:
+    // Файл path перезаписан заданием: следующие обращения загрузят его заново. Задания,
+    // уже получившие прежний операнд, продолжают работать с ним
+    void forget(const string& path) {
+        lock_guard<mutex> guard(lock);
+        vectors.erase(path);
+        matrices.erase(path);
+        solvers.erase(path);
     }
 
-    // Подсчет элементов матрицы
-    unsigned countMatrixElements = calcResults.matrixResult.rows * calcResults.matrixResult.cols;
+    shared_ptr<const VectorData> vector(const string& path) { return get(lock, vectors, path, readDataFromFile); }
+    shared_ptr<const MatrixData> matrix(const string& path) { return get(lock, matrices, path, readMatrixFromFile); }
+    // Разложение матрицы из файла path: задания с одной матрицей системы раскладывают ее один раз
+    shared_ptr<const LinearSolver> solver(const string& path, const MatrixData& a) {
+        return get(lock, solvers, path, [&](const string&) { return factorMatrix(a); });
+    }
+};
 
-    // Проверка на наличие данных для записи в матрицу
-    if (countMatrixElements > 0) {
-        dataFile << "Matrix Result:" << endl; // Заголовок для матрицы
-        for (unsigned i = 0; i < calcResults.matrixResult.rows; ++i) {
-            for (unsigned j = 0; j < calcResults.matrixResult.cols; ++j) {
-                dataFile << calcResults.matrixResult.matrix.getElement(i, j) << " "; // Записываем элементы матрицы
+shared_ptr<const VectorData> loadVector(OperandCache* cache, const string& path) {
+    return cache != nullptr ? cache->vector(path) : make_shared<const VectorData>(readDataFromFile(path));
+}
+
+shared_ptr<const MatrixData> loadMatrix(OperandCache* cache, const string& path) {
+    return cache != nullptr ? cache->matrix(path) : make_shared<const MatrixData>(readMatrixFromFile(path));
+}
+
+shared_ptr<const LinearSolver> loadSolver(OperandCache* cache, const string& path, const MatrixData& a) {
+    return cache != nullptr && !path.empty() ? cache->solver(path, a) : make_shared<const LinearSolver>(factorMatrix(a));
+}
+
+void runCommand(const vector<string>& argv, OperandCache* cache);
+
+// Разбиение строки задания на аргументы: разделители - пробелы, в кавычках можно
+// записать аргумент с пробелами (например, выражение "a + b - c * 2")
+vector<string> splitJobLine(const string& line) {
+    vector<string> args;
+    string current;
+    bool quoted = false, hasToken = false;
+    for (char ch : line) {
+        if (ch == '"') {
+            quoted = !quoted;
+            hasToken = true;
+        } else if (!quoted && (ch == ' ' || ch == '\t' || ch == '\r')) {
+            if (hasToken) {
+                args.push_back(current);
+                current.clear();
+                hasToken = false;
+            }
+        } else {
+            current += ch;
+            hasToken = true;
+        }
+    }
+    if (hasToken) {
+        args.push_back(current);
+    }
+    return args;
+}
+
+// Пакетный режим: каждая непустая строка файла (кроме комментариев '#') - отдельное
+// задание с аргументами как в командной строке, например
+//     --matrix_fp1 a.txt --matrix_fp2 b.txt --op mm_sum --exp out.txt
+// Операнды загружаются через общий кэш. Задания, связанные через файлы (пишут в один
+// выходной файл или читают файл, который пишет другое задание), объединяются в группу
+// и выполняются по порядку файла заданий: результаты дописываются в том же порядке,
+// а операнд читается уже после записи, стоящей выше. Если групп не меньше, чем потоков
+// пула, группы выполняются параллельно (каждое задание в одном потоке); иначе группы
+// идут по очереди, а каждое задание само использует все ядра (умножение, разложение, экспорт)
+void runJobFile(const string& path) {
+    vector<vector<string>> jobs;
+    {
+        ifstream file;
+        if (path != "-") {
+            file.open(path);
+            if (!file) {
+                LOG_ERROR("Ошибка открытия файла заданий: " + path);
+                return;
             }
-            dataFile << endl; // Переход на новую строку после каждой строки матрицы
         }
-    } else {
-        logAll("Нет данных для записи матрицы.");
+        istream& in = path == "-" ? cin : file;
+        string line;
+        while (getline(in, line)) {
+            vector<string> args = splitJobLine(line);
+            if (!args.empty() && args[0][0] != '#') {
+                jobs.push_back(move(args));
+            }
+        }
+    }
+
+    // Файлы, которые задание пишет (--exp, выход --convert) или читает (операнды, вход --convert)
+    auto filesOf = [](const vector<string>& job, bool writes) {
+        static const char* const readFlags[] = {"--fp1", "--fp2", "--fp3", "--matrix_fp1", "--matrix_fp2",
+                                                "--matrix_fp3", "--convert"};
+        vector<string> paths;
+        for (size_t k = 0; k + 1 < job.size(); ++k) {
+            if (writes) {
+                size_t targetIndex = k + (job[k] == "--convert" ? 2 : 1);
+                if ((job[k] == "--exp" || job[k] == "--convert") && targetIndex < job.size()) {
+                    paths.push_back(job[targetIndex]);
+                }
+            } else if (find(begin(readFlags), end(readFlags), job[k]) != end(readFlags)) {
+                paths.push_back(job[k + 1]);
+            }
+        }
+        return paths;
+    };
+
+    // Объединение заданий, работающих с одним перезаписываемым файлом (система
+    // непересекающихся множеств). Файлы, которые только читаются, задания не связывают
+    vector<size_t> parent(jobs.size());
+    for (size_t j = 0; j < jobs.size(); ++j) {
+        parent[j] = j;
+    }
+    function<size_t(size_t)> root = [&](size_t j) { return parent[j] == j ? j : parent[j] = root(parent[j]); };
+    const size_t NO_JOB = SIZE_MAX;
+    map<string, size_t> firstUser; // Первое задание, работающее с перезаписываемым файлом
+    for (const vector<string>& job : jobs) {
+        for (const string& target : filesOf(job, true)) {
+            firstUser.emplace(target, NO_JOB);
+        }
+    }
+    for (size_t j = 0; j < jobs.size(); ++j) {
+        for (bool writes : {false, true}) {
+            for (const string& file : filesOf(jobs[j], writes)) {
+                auto it = firstUser.find(file);
+                if (it == firstUser.end()) {
+                    continue;
+                }
+                if (it->second == NO_JOB) {
+                    it->second = j;
+                } else {
+                    parent[root(j)] = root(it->second);
+                }
+            }
+        }
+    }
+    // Группы по порядку их первого задания, задания в группе - по порядку файла
+    vector<vector<size_t>> groups;
+    map<size_t, size_t> groupOfRoot;
+    for (size_t j = 0; j < jobs.size(); ++j) {
+        auto entry = groupOfRoot.emplace(root(j), groups.size());
+        if (entry.second) {
+            groups.emplace_back();
+        }
+        groups[entry.first->second].push_back(j);
     }
 
-    dataFile.close(); // Закрываю файл
-    return 0; 
+    LOG_INFO("Пакетный режим: заданий " + to_string(jobs.size()) + ", независимых групп " + to_string(groups.size()));
+    OperandCache cache;
+    auto t0 = chrono::high_resolution_clock::now();
+    auto runGroup = [&](size_t g, size_t) {
+        for (size_t j : groups[g]) {
+            // Ошибка в задании (например, неверное число в аргументе) не прерывает пакет
+            try {
+                runCommand(jobs[j], &cache);
+            } catch (const exception& e) {
+                string line;
+                for (const string& arg : jobs[j]) {
+                    line += (line.empty() ? "" : " ") + arg;
+                }
+                LOG_ERROR("Ошибка в задании " + to_string(j + 1) + " (" + line + "): " + e.what());
+            }
+        }
+    };
+    if (groups.size() >= parallelWorkers()) {
+        parallelTasks(groups.size(), runGroup);
+    } else {
+        for (size_t g = 0; g < groups.size(); ++g) {
+            runGroup(g, 0);
+        }
+    }
+    double seconds = chrono::duration<double>(chrono::high_resolution_clock::now() - t0).count();
+    cout << "Выполнено заданий: " << jobs.size() << " за " << seconds << " с" << endl;
 }
 
-int main(int argc, char* argv[]) {
-    VectorData vector1, vector2;
-    MatrixData matrix1, matrix2;
+// Выполнение одной команды: аргументы обрабатываются по порядку, как в командной строке.
+// Если задан cache, операнды берутся из общего кэша пакетного режима
+void runCommand(const vector<string>& argv, OperandCache* cache) {
+    const int argc = int(argv.size());
+    // Операнды a, b, c для --op: векторы из --fp1..--fp3, матрицы из --matrix_fp1..--matrix_fp3
+    shared_ptr<const VectorData> vectors[FusedExpression::MAX_OPERANDS];
+    shared_ptr<const MatrixData> matrices[FusedExpression::MAX_OPERANDS];
+    for (int k = 0; k < FusedExpression::MAX_OPERANDS; ++k) {
+        vectors[k] = make_shared<const VectorData>();
+        matrices[k] = make_shared<const MatrixData>();
+    }
     CalcProblemParams calcParams;
     CalcResults calcResult;
+    // Разложение матрицы системы для --op solve сохраняется, пока не загружена другая матрица 1
+    string systemPath;
+    shared_ptr<const MatrixData> systemMatrix;
+    shared_ptr<const LinearSolver> solver;
+    // Метод решения для --op solve: auto - прямой для плотной матрицы, BiCGSTAB + ILU(0) для разреженной
+    string method = "auto", precond = "auto";
+    IterativeOptions iterative;
 
-    for (int i = 1; i < argc; i++) {
+    for (int i = 0; i < argc; i++) {
         if (string(argv[i]) == "--fp1") {
             if (i + 1 < argc) {
                 calcParams.filePath1 = argv[i + 1];
-                logAll("Путь к файлу 1: " + calcParams.filePath1);
-                vector1 = readDataFromFile(calcParams.filePath1);
+                LOG_INFO("Путь к файлу 1: " + calcParams.filePath1);
+                vectors[0] = loadVector(cache, calcParams.filePath1);
                 i++;} 
         } else if (string(argv[i]) == "--fp2") {
             if (i + 1 < argc) {
                 calcParams.filePath2 = argv[i + 1];
-                logAll("Путь к файлу 2: " + calcParams.filePath2);
-                vector2 = readDataFromFile(calcParams.filePath2);
+                LOG_INFO("Путь к файлу 2: " + calcParams.filePath2);
+                vectors[1] = loadVector(cache, calcParams.filePath2);
+                i++;
+            }
+        } else if (string(argv[i]) == "--fp3") {
+            if (i + 1 < argc) {
+                calcParams.filePath3 = argv[i + 1];
+                LOG_INFO("Путь к файлу 3: " + calcParams.filePath3);
+                vectors[2] = loadVector(cache, calcParams.filePath3);
                 i++;
             }
+        } else if (string(argv[i]) == "--matrix_fp3") {
+            if (i + 1 < argc) {
+                calcParams.filePath3 = argv[i + 1];
+                LOG_INFO("Путь к файлу матрицы 3: " + calcParams.filePath3);
+                matrices[2] = loadMatrix(cache, calcParams.filePath3);
+                i++;
+            } else {
+                LOG_ERROR("Ошибка: нет аргумента после --matrix_fp3");
+            }
         } if (string(argv[i]) == "--matrix_fp1") {
             if (i + 1 < argc) {
                 calcParams.filePath1 = argv[i + 1];
-                logAll("Путь к файлу матрицы 1: " + calcParams.filePath1);
-                matrix1 = readMatrixFromFile(calcParams.filePath1);
+                LOG_INFO("Путь к файлу матрицы 1: " + calcParams.filePath1);
+                matrices[0] = loadMatrix(cache, calcParams.filePath1);
+                systemPath = calcParams.filePath1;
                 i++;
             } else {
-                logAll("Ошибка: нет аргумента после --matrix_fp1");
+                LOG_ERROR("Ошибка: нет аргумента после --matrix_fp1");
             }
         } if (string(argv[i]) == "--matrix_fp2") {
             if (i + 1 < argc) {
                 calcParams.filePath2 = argv[i + 1];
-                logAll("Путь к файлу матрицы 2: " + calcParams.filePath2);
-                matrix2 = readMatrixFromFile(calcParams.filePath2);
+                LOG_INFO("Путь к файлу матрицы 2: " + calcParams.filePath2);
+                matrices[1] = loadMatrix(cache, calcParams.filePath2);
                 i++;
             } else {
-                logAll("Ошибка: нет аргумента после --matrix_fp2");
+                LOG_ERROR("Ошибка: нет аргумента после --matrix_fp2");
             }
         } else if (string(argv[i]) == "--op") {
             if (i + 1 < argc) {
                 string operation = argv[i + 1];
-                logAll("Операция: " + operation);
+                LOG_INFO("Операция: " + operation);
                 if (operation == "vv_sum") {
                     calcParams.op = CalcProblemParams::operations::vv_sum;
-                    logAll("Вызвана операция: суммирование векторов");
-                    calcResult.result = Calck_vv_sum(vector1, vector2);
+                    LOG_INFO("Вызвана операция: суммирование векторов");
+                    calcResult.result = Calck_vv_sum(*vectors[0], *vectors[1]);
                 } else if (operation == "vv_sub") {
                     calcParams.op = CalcProblemParams::operations::vv_sub;
-                    logAll("Вызвана операция: вычитание векторов");
-                    calcResult.result = Calck_vv_sub(vector1,vector2);
+                    LOG_INFO("Вызвана операция: вычитание векторов");
+                    calcResult.result = Calck_vv_sub(*vectors[0], *vectors[1]);
                 } else if (operation == "mm_sum") {
                     calcParams.op = CalcProblemParams::operations::mm_sum;
-                    logAll("Вызвана операция: суммирование матриц");
-                    calcResult.matrixResult = Calck_mm_sum(matrix1, matrix2);
+                    LOG_INFO("Вызвана операция: суммирование матриц");
+                    calcResult.matrixResult = Calck_mm_sum(*matrices[0], *matrices[1]);
                     // Вывод результата сложения матриц
                     // for (unsigned i = 0; i < calcResult.matrixResult.rows; ++i) {
                     //     for (unsigned j = 0; j < calcResult.matrixResult.cols; ++j) {
@@ -348,27 +4473,227 @@ int main(int argc, char* argv[]) {
                     //     }
                     //     cout << endl; // Переход на новую строку после каждой строки матрицы
                     // }
+                } else if (operation == "mm_mul") {
+                    calcParams.op = CalcProblemParams::operations::mm_mul;
+                    LOG_INFO("Вызвана операция: умножение матриц");
+                    calcResult.matrixResult = Calck_mm_mul(*matrices[0], *matrices[1]);
+                } else if (operation == "mv_mul") {
+                    calcParams.op = CalcProblemParams::operations::mv_mul;
+                    LOG_INFO("Вызвана операция: умножение матрицы на вектор");
+                    calcResult.result = Calck_mv_mul(*matrices[0], *vectors[1]);
+                } else if (operation == "solve") {
+                    // A из --matrix_fp1, правая часть - матрица из --matrix_fp2 или вектор из --fp2
+                    calcParams.op = CalcProblemParams::operations::solve;
+                    LOG_INFO("Вызвана операция: решение системы A X = B");
+                    if (method == "direct" || (method == "auto" && !matrices[0]->isSparse)) {
+                        if (systemMatrix != matrices[0]) {
+                            systemMatrix = matrices[0];
+                            solver = loadSolver(cache, systemPath, *systemMatrix);
+                        } else {
+                            LOG_INFO("Используется готовое разложение матрицы системы");
+                        }
+                        Calck_solve(*solver, *matrices[1], *vectors[1], calcResult);
+                    } else {
+                        IterativeMethod iterativeMethod = method == "cg" ? IterativeMethod::CG
+                                                          : method == "gmres" ? IterativeMethod::GMRES
+                                                          : IterativeMethod::BiCGStab;
+                        PreconditionerKind precondKind = precond == "none" ? PreconditionerKind::None
+                                                         : precond == "jacobi" ? PreconditionerKind::Jacobi
+                                                         : PreconditionerKind::ILU0;
+                        Calck_solve_iterative(*matrices[0], iterativeMethod, precondKind, iterative,
+                                              *matrices[1], *vectors[1], calcResult);
+                    }
                 } else {
-                    logAll("Ошибка: неизвестная операция");
+                    // Выражение над операндами a, b, c, например "a + b - c * 2"
+                    calcParams.op = CalcProblemParams::operations::expression;
+                    LOG_INFO("Вызвана операция: вычисление выражения");
+                    const VectorData* vectorOperands[FusedExpression::MAX_OPERANDS];
+                    const MatrixData* matrixOperands[FusedExpression::MAX_OPERANDS];
+                    for (int k = 0; k < FusedExpression::MAX_OPERANDS; ++k) {
+                        vectorOperands[k] = vectors[k].get();
+                        matrixOperands[k] = matrices[k].get();
+                    }
+                    if (!Calck_expression(operation, vectorOperands, matrixOperands, calcResult)) {
+                        LOG_ERROR("Ошибка: неизвестная операция или неверное выражение");
+                    }
                 }
                 i++; // Увеличиваем индекс, чтобы пропустить следующий аргумент
             } else {
-                logAll("Ошибка: нет аргумента после --op");
+                LOG_ERROR("Ошибка: нет аргумента после --op");
+            }
+        } else if (string(argv[i]) == "--method") {
+            // --method auto|direct|cg|bicgstab|gmres для --op solve
+            if (i + 1 < argc) {
+                method = argv[i + 1];
+                i++;
+            } else {
+                LOG_ERROR("Ошибка: нет аргумента после --method");
+            }
+        } else if (string(argv[i]) == "--precond") {
+            // --precond auto|none|jacobi|ilu0 для итерационных методов (auto - ILU(0))
+            if (i + 1 < argc) {
+                precond = argv[i + 1];
+                i++;
+            } else {
+                LOG_ERROR("Ошибка: нет аргумента после --precond");
+            }
+        } else if (string(argv[i]) == "--tol") {
+            if (i + 1 < argc) {
+                iterative.tolerance = stod(argv[i + 1]);
+                i++;
+            }
+        } else if (string(argv[i]) == "--maxit") {
+            if (i + 1 < argc) {
+                iterative.maxIterations = stoull(argv[i + 1]);
+                i++;
+            }
+        } else if (string(argv[i]) == "--restart") {
+            // Размер базиса GMRES до перезапуска
+            if (i + 1 < argc) {
+                iterative.restart = stoull(argv[i + 1]);
+                i++;
+            }
+        } else if (string(argv[i]) == "--bench_log") {
+            // --bench_log [строки столбцы], по умолчанию 10000x10000
+            unsigned rows = 10000, cols = 10000;
+            if (i + 2 < argc) {
+                rows = stoul(argv[i + 1]);
+                cols = stoul(argv[i + 2]);
+                i += 2;
+            }
+            runLogBenchmark(rows, cols);
+        } else if (string(argv[i]) == "--bench_parse") {
+            // --bench_parse [строки столбцы], по умолчанию 10000x10000
+            unsigned rows = 10000, cols = 10000;
+            if (i + 2 < argc) {
+                rows = stoul(argv[i + 1]);
+                cols = stoul(argv[i + 2]);
+                i += 2;
+            }
+            runParseBenchmark(rows, cols);
+        } else if (string(argv[i]) == "--bench_binary") {
+            // --bench_binary [строки столбцы], по умолчанию 10000x10000
+            unsigned rows = 10000, cols = 10000;
+            if (i + 2 < argc) {
+                rows = stoul(argv[i + 1]);
+                cols = stoul(argv[i + 2]);
+                i += 2;
+            }
+            runBinaryBenchmark(rows, cols);
+        } else if (string(argv[i]) == "--bench_pool") {
+            // --bench_pool [строки столбцы операции], по умолчанию 2000x2000, 50 операций
+            unsigned rows = 2000, cols = 2000, iterations = 50;
+            if (i + 3 < argc) {
+                rows = stoul(argv[i + 1]);
+                cols = stoul(argv[i + 2]);
+                iterations = stoul(argv[i + 3]);
+                i += 3;
+            }
+            runPoolBenchmark(rows, cols, iterations);
+        } else if (string(argv[i]) == "--bench_expr") {
+            // --bench_expr [число элементов], по умолчанию 10 миллионов
+            size_t n = 10000000;
+            if (i + 1 < argc) {
+                n = stoull(argv[i + 1]);
+                i++;
+            }
+            runExpressionBenchmark(n);
+        } else if (string(argv[i]) == "--bench_gemm") {
+            // --bench_gemm [n], по умолчанию 1024
+            unsigned n = 1024;
+            if (i + 1 < argc) {
+                n = stoul(argv[i + 1]);
+                i++;
+            }
+            runGemmBenchmark(n);
+        } else if (string(argv[i]) == "--bench_solve") {
+            // --bench_solve [n ...], по умолчанию 1000 2000 4000; допустимо до 16000 при 4+ ГБ памяти
+            vector<unsigned> sizes;
+            while (i + 1 < argc && argv[i + 1].compare(0, 2, "--") != 0) {
+                sizes.push_back(stoul(argv[i + 1]));
+                i++;
+            }
+            if (sizes.empty()) {
+                sizes = {1000, 2000, 4000};
+            }
+            runSolveBenchmark(sizes);
+        } else if (string(argv[i]) == "--bench_iterative") {
+            // --bench_iterative [размер сетки], по умолчанию 512x512
+            unsigned grid = 512;
+            if (i + 1 < argc) {
+                grid = stoul(argv[i + 1]);
+                i++;
+            }
+            runIterativeBenchmark(grid);
+        } else if (string(argv[i]) == "--bench_sparse") {
+            // --bench_sparse [n доля_ненулевых], по умолчанию 4000 и 0.001
+            unsigned n = 4000;
+            double density = 0.001;
+            if (i + 2 < argc) {
+                n = stoul(argv[i + 1]);
+                density = stod(argv[i + 2]);
+                i += 2;
+            }
+            runSparseBenchmark(n, density);
+        } else if (string(argv[i]) == "--jobs") {
+            // --jobs файл: пакетный режим, "-" - задания читаются из стандартного ввода
+            if (i + 1 < argc) {
+                runJobFile(argv[i + 1]);
+                i++;
+            } else {
+                LOG_ERROR("Ошибка: нет аргумента после --jobs");
+            }
+        } else if (string(argv[i]) == "--bench_elementwise") {
+            // --bench_elementwise [число элементов], по умолчанию 50 миллионов
+            size_t n = 50000000;
+            if (i + 1 < argc) {
+                n = stoull(argv[i + 1]);
+                i++;
+            }
+            runElementwiseBenchmark(n);
+        } else if (string(argv[i]) == "--bench_export") {
+            // --bench_export [строки столбцы], по умолчанию 10000x10000
+            unsigned rows = 10000, cols = 10000;
+            if (i + 2 < argc) {
+                rows = stoul(argv[i + 1]);
+                cols = stoul(argv[i + 2]);
+                i += 2;
+            }
+            runExportBenchmark(rows, cols);
+        } else if (string(argv[i]) == "--convert") {
+            // --convert вход выход: текст -> бинарный или бинарный -> текст
+            if (i + 2 < argc) {
+                if (convertMatrixFile(argv[i + 1], argv[i + 2]) != 0) {
+                    LOG_ERROR("Ошибка при конвертации матрицы");
+                }
+                if (cache != nullptr) {
+                    cache->forget(argv[i + 2]);
+                }
+                i += 2;
+            } else {
+                LOG_ERROR("Ошибка: нужны два аргумента после --convert");
             }
         }else if (string(argv[i]) == "--exp") {
         if (i + 1 < argc) { // Проверка границ
             ExportConfig conf;
             conf.path = argv[i + 1]; // Сохраняем путь к файлу
-            logAll("Путь и имя выходного файла: " + conf.path);
+            LOG_INFO("Путь и имя выходного файла: " + conf.path);
             // Вызов функции Export с нужными аргументами
             int exportResult = Export(calcResult, conf);
             if (exportResult != 0) {
-                logAll("Ошибка при экспорте данных");
+                LOG_ERROR("Ошибка при экспорте данных");
+            }
+            if (cache != nullptr) {
+                cache->forget(conf.path);
             }
         } else {
-            logAll("Ошибка: нет аргументов после --exp");
+            LOG_ERROR("Ошибка: нет аргументов после --exp");
         }
     }
 }
+}
+
+int main(int argc, char* argv[]) {
+    runCommand(vector<string>(argv + 1, argv + argc), nullptr);
     return 0;
-}
\ No newline at end of file
+}